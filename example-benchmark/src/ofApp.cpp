@@ -0,0 +1,277 @@
+#include "ofApp.h"
+
+using namespace ofxKinectObjects;
+
+static const int width = 640;
+static const int height = 480;
+static const int iterations = 100;
+static const int trackingFrames = 600;
+
+//Kinect-like pinhole rays: 0.1042 mm zero plane pixel size at 120 mm
+static vector<ofVec3f> makeRays(){
+    vector<ofVec3f> rays(width * height);
+    float factor = 2 * 0.1042 / 120.0;
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            rays[j * width + i] = ofVec3f((i - width / 2) * factor, (j - height / 2) * factor, 1);
+        }
+    }
+    return rays;
+}
+
+//Table 1 m below the sensor with boxes and a hand above it
+static vector<unsigned short> makeDepth(){
+    vector<unsigned short> depth(width * height);
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            unsigned short z = 1000 + ofRandom(-3, 3);
+            if ((i / 80) % 2 == 0 && (j / 80) % 2 == 0) {
+                z -= 30;
+            } else if (i > 400 && j > 300) {
+                z -= 100;
+            }
+            depth[j * width + i] = z;
+        }
+    }
+    return depth;
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+    benchmarkSegmentation();
+    benchmarkTracking();
+    ofExit();
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkSegmentation(){
+    vector<ofVec3f> rays = makeRays();
+    vector<unsigned short> depth = makeDepth();
+    ofVec3f v0(0, 0, 1000);
+    ofVec3f n(0, 0, 1);
+    ofVec2f floorThreshold(10, 60);
+    ofVec2f handsThreshold(60, 250);
+    
+    //Previous ObjectTracker::update() loop: column-major, unprojecting twice per pixel
+    ofPixels objPixels, handsPixels;
+    objPixels.allocate(width, height, OF_IMAGE_GRAYSCALE);
+    handsPixels.allocate(width, height, OF_IMAGE_GRAYSCALE);
+    unsigned long long start = ofGetElapsedTimeMicros();
+    for (int k = 0; k < iterations; k++) {
+        for (int i = 0; i < width; i++) {
+            for (int j = 0; j < height; j++) {
+                if (ofInRange(fabsf(n.dot(rays[j * width + i] * depth[j * width + i] - v0)), floorThreshold.x, floorThreshold.y)) {
+                    objPixels.setColor(i, j, 255);
+                    handsPixels.setColor(i, j, 0);
+                } else if (ofInRange(fabsf(n.dot(rays[j * width + i] * depth[j * width + i] - v0)), handsThreshold.x, handsThreshold.y)) {
+                    objPixels.setColor(i, j, 0);
+                    handsPixels.setColor(i, j, 255);
+                } else {
+                    objPixels.setColor(i, j, 0);
+                    handsPixels.setColor(i, j, 0);
+                }
+            }
+        }
+    }
+    float legacy = (ofGetElapsedTimeMicros() - start) / float(iterations);
+    
+    DepthSegmenter segmenter;
+    segmenter.setup(width, height);
+    segmenter.setRays(rays);
+    segmenter.setBackgroundPlane(v0, n);
+    cv::Mat objectsMask, handsMask;
+    
+    start = ofGetElapsedTimeMicros();
+    for (int k = 0; k < iterations; k++) {
+        segmenter.segmentScalar(&depth[0], objectsMask, handsMask, floorThreshold, handsThreshold);
+    }
+    float scalar = (ofGetElapsedTimeMicros() - start) / float(iterations);
+    
+    start = ofGetElapsedTimeMicros();
+    for (int k = 0; k < iterations; k++) {
+        segmenter.segment(&depth[0], objectsMask, handsMask, floorThreshold, handsThreshold);
+    }
+    float vectorized = (ofGetElapsedTimeMicros() - start) / float(iterations);
+    
+    ofLogNotice("segmentation") << width << "x" << height << ", " << iterations << " frames";
+    ofLogNotice("segmentation") << "previous loop:  " << legacy << " us/frame";
+    ofLogNotice("segmentation") << "scalar kernel:  " << scalar << " us/frame (" << legacy / scalar << "x)";
+    ofLogNotice("segmentation") << "simd kernel:    " << vectorized << " us/frame (" << legacy / vectorized << "x)";
+    
+    for (int step = 2; step <= 4; step *= 2) {
+        start = ofGetElapsedTimeMicros();
+        for (int k = 0; k < iterations; k++) {
+            segmenter.segment(&depth[0], objectsMask, handsMask, floorThreshold, handsThreshold, step);
+        }
+        float decimated = (ofGetElapsedTimeMicros() - start) / float(iterations);
+        ofLogNotice("segmentation") << "simd kernel 1/" << step << ": " << decimated << " us/frame (" << legacy / decimated << "x)";
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkTracking(){
+    int resolutions[3][2] = {{320, 240}, {640, 480}, {1280, 960}};
+    int objectCounts[3] = {4, 16, 40};
+    
+    ofLogNotice("tracking") << "synthetic scene, " << trackingFrames << " frames, a new one on every update()";
+    ofLogNotice("tracking") << "resolution objects mode      hands every tiles ccl    fps   p50 us   p95 us   p99 us   lag  touches  delay avg/max  missed  false";
+    for (int r = 0; r < 3; r++) {
+        for (int o = 0; o < 3; o++) {
+            runTracking(resolutions[r][0], resolutions[r][1], objectCounts[o], false);
+            runTracking(resolutions[r][0], resolutions[r][1], objectCounts[o], true);
+        }
+    }
+    
+    //Hands at lower resolution, objects at full
+    for (int r = 1; r < 3; r++) {
+        for (int decimation = 2; decimation <= 4; decimation *= 2) {
+            runTracking(resolutions[r][0], resolutions[r][1], 16, false, decimation);
+        }
+    }
+    
+    //Objects every 10 frames, and every 60 or when they change
+    for (int r = 1; r < 3; r++) {
+        runTracking(resolutions[r][0], resolutions[r][1], 16, false, 1, 10);
+        runTracking(resolutions[r][0], resolutions[r][1], 16, false, 1, 60, 200);
+    }
+    
+    //Incremental segmentation
+    for (int r = 1; r < 3; r++) {
+        runTracking(resolutions[r][0], resolutions[r][1], 16, false, 1, 1, 0, 32);
+        runTracking(resolutions[r][0], resolutions[r][1], 16, false, 1, 1, 0, 16);
+    }
+    
+    //Single pass labeling
+    for (int r = 1; r < 3; r++) {
+        runTracking(resolutions[r][0], resolutions[r][1], 16, false, 1, 1, 0, 0, true);
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::runTracking(int width, int height, int objects, bool pipelined, int handsDecimation, int objectsInterval, float objectsChangeArea, int tileSize, bool singlePassLabeling){
+    shared_ptr<SyntheticSource> synthetic(new SyntheticSource(width, height));
+    synthetic->setObjectCount(objects);
+    synthetic->setHandCount(MAX(objects / 4, 1));
+    synthetic->setEmpty(true);
+    
+    ObjectTracker objectTracker;
+    objectTracker.setPipelined(pipelined);
+    objectTracker.setHeadless(true);
+    objectTracker.setPerHandEvents(false);
+    objectTracker.setDecimation(1, handsDecimation);
+    objectTracker.setObjectsSchedule(objectsInterval, objectsChangeArea);
+    objectTracker.setIncrementalSegmentation(tileSize);
+    objectTracker.setSinglePassLabeling(singlePassLabeling);
+    objectTracker.setup(vector<shared_ptr<DepthSource> >(1, synthetic));
+    
+    //Objects 50mm and hands 150mm above the table, sizes as the synthetic ones
+    float area = (width / 640.f) * (width / 640.f);
+    objectTracker.updateParameters(ofVec2f(20, 100), ofVec2f(110, 400), ofVec2f(400 * area, 4000 * area), ofVec2f(150 * area, 3000 * area), false);
+    
+    //Background from the empty table
+    objectTracker.startAutoBgCalibration(30);
+    while (objectTracker.isAutoBgCalibrating()) {
+        objectTracker.update();
+    }
+    synthetic->setEmpty(false);
+    
+    source = synthetic.get();
+    ofAddListener(FrameTrackedEvent::events, this, &ofApp::frameTracked);
+    
+    vector<float> latencies;
+    vector<int> handTouching(synthetic->getHandCount(), -1);
+    //Frame each object started being touched, 0 if it isn't or it was detected
+    vector<unsigned long long> touchStarts(synthetic->getObjectCount(), 0);
+    vector<int> delays;
+    int touches = 0, missed = 0, falseTouches = 0;
+    unsigned long long lag = 0, trackedFrames = 0, lastTracked = 0;
+    
+    unsigned long long start = ofGetElapsedTimeMicros();
+    for (int frame = 0; frame < trackingFrames; frame++) {
+        detectedTouches.clear();
+        unsigned long long updateStart = ofGetElapsedTimeMicros();
+        objectTracker.update();
+        latencies.push_back(ofGetElapsedTimeMicros() - updateStart);
+        
+        unsigned long long tracked = objectTracker.getSnapshot().frameNumber;
+        trackedFrames += tracked != lastTracked;
+        lastTracked = tracked;
+        lag += synthetic->getFrameNumber() - tracked;
+        
+        //Ground truth first: touches reported in this update() may be of this frame
+        for (int h = 0; h < handTouching.size(); h++) {
+            int object = synthetic->getTouchedObject(h);
+            if (object != -1 && object != handTouching[h]) {
+                missed += touchStarts[object] != 0;
+                touchStarts[object] = synthetic->getFrameNumber();
+                touches++;
+            }
+            handTouching[h] = object;
+        }
+        for (int i = 0; i < detectedTouches.size(); i++) {
+            int object = detectedTouches[i].first;
+            if (object == -1 || touchStarts[object] == 0) {
+                falseTouches++;
+                continue;
+            }
+            delays.push_back(detectedTouches[i].second - touchStarts[object]);
+            touchStarts[object] = 0;
+        }
+    }
+    float seconds = (ofGetElapsedTimeMicros() - start) / 1000000.f;
+    for (int i = 0; i < touchStarts.size(); i++) {
+        missed += touchStarts[i] != 0;
+    }
+    
+    ofRemoveListener(FrameTrackedEvent::events, this, &ofApp::frameTracked);
+    objectTracker.exit();
+    
+    sort(latencies.begin(), latencies.end());
+    float delayMean = 0;
+    int delayMax = 0;
+    for (int i = 0; i < delays.size(); i++) {
+        delayMean += delays[i] / float(delays.size());
+        delayMax = MAX(delayMax, delays[i]);
+    }
+    
+    ofLogNotice("tracking") << ofToString(width) + "x" + ofToString(height) << " "
+    << ofToString(synthetic->getObjectCount(), 7, ' ') << " "
+    << (pipelined ? "pipelined" : "serial   ") << " "
+    << ofToString("1/" + ofToString(handsDecimation), 5, ' ') << " "
+    << ofToString(ofToString(objectsInterval) + (objectsChangeArea > 0 ? "+" : ""), 5, ' ') << " "
+    << ofToString(tileSize, 5, ' ') << " "
+    << (singlePassLabeling ? "yes" : "no ") << " "
+    << ofToString(trackedFrames / seconds, 1, 6, ' ') << " "
+    << ofToString(latencies[latencies.size() / 2], 0, 8, ' ') << " "
+    << ofToString(latencies[latencies.size() * 95 / 100], 0, 8, ' ') << " "
+    << ofToString(latencies[latencies.size() * 99 / 100], 0, 8, ' ') << " "
+    << ofToString(lag / float(trackingFrames), 1, 5, ' ') << " "
+    << ofToString(touches, 8, ' ') << " "
+    << ofToString(delayMean, 1, 9, ' ') << "/" << ofToString(delayMax, 3, ' ') << " "
+    << ofToString(missed, 7, ' ') << " "
+    << ofToString(falseTouches, 6, ' ');
+}
+
+//--------------------------------------------------------------
+void ofApp::frameTracked(FrameTrackedEvent& e){
+    for (int t = 0; t < e.touches->size(); t++) {
+        const TouchEvent& touch = (*e.touches)[t];
+        if (!touch.touched) {
+            continue;
+        }
+        //Synthetic object under the touched object
+        int object = -1;
+        for (int i = 0; i < e.objects->size() && object == -1; i++) {
+            const ObjectState& state = (*e.objects)[i];
+            if (state.label != touch.objectLabel) {
+                continue;
+            }
+            for (int k = 0; k < source->getObjectCount(); k++) {
+                if (source->getObjectRect(k).inside(state.centroid)) {
+                    object = k;
+                }
+            }
+        }
+        detectedTouches.push_back(make_pair(object, e.frameNumber));
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxKinectObjects.h"
+
+class ofApp : public ofBaseApp{
+public:
+    void setup();
+    
+private:
+    void benchmarkSegmentation();
+    void benchmarkTracking();
+    void runTracking(int width, int height, int objects, bool pipelined, int handsDecimation = 1, int objectsInterval = 1, float objectsChangeArea = 0, int tileSize = 0, bool singlePassLabeling = false);
+    void frameTracked(FrameTrackedEvent& e);
+    
+    //Touches the tracker reported in the current update(): synthetic object, frame
+    ofxKinectObjects::SyntheticSource* source;
+    vector<pair<int, unsigned long long> > detectedTouches;
+};
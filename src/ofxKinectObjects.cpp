@@ -9,17 +9,28 @@
 #include "ofxKinectObjects.h"
 
 namespace ofxKinectObjects {
+    
+    //Time the kinect motor takes to tilt
+    static const float tiltSeconds = 2;
+    
     /***
      OBJECTS
      **___________________________________*/
+    FloorObject::FloorObject(){
+        area_ = 0;
+        category_ = 0;
+        touchedBy_ = noLabel;
+        updated_ = false;
+    }
+    
     FloorObject::FloorObject(float area, ofVec3f worldCoordinates, vector<ofPoint> quad){
         area_ = area;
-        touchedBy_ = 0;
+        category_ = 0;
+        touchedBy_ = noLabel;
+        updated_ = false;
         //touched_ = false;
         quad_ = quad;
         worldCoordinates_ = worldCoordinates;
-        ofAddListener(HandOnEvent::events, this, &FloorObject::handOn);
-        ofAddListener(HandOutEvent::events, this, &FloorObject::handOut);
     }
     
     float FloorObject::getArea(){
@@ -59,7 +70,11 @@ namespace ofxKinectObjects {
     }
     
     bool FloorObject::isTouched (){
-        return (touchedBy_ != 0);
+        return (touchedBy_ != noLabel);
+    }
+    
+    unsigned int FloorObject::getTouchedBy(){
+        return touchedBy_;
     }
     
     void FloorObject::handOn(HandOnEvent &e){
@@ -72,24 +87,22 @@ namespace ofxKinectObjects {
         //    - same hand & distance > lim --> untouch
         
         //if (touchedBy_ == 0 && (e.worldCoordinates.distance(worldCoordinates_) < 100)) {
-        if (touchedBy_ == 0 && (quadIntersects(e.quad))) {
+        if (touchedBy_ == noLabel && (quadIntersects(e.quad))) {
             touch(e.handLabel);
         } else if (touchedBy_ == e.handLabel && !(quadIntersects(e.quad))){
-            touch(0);
+            touch(noLabel);
         }
     }
     
     void FloorObject::handOut(HandOutEvent &e){
         if (e.handLabel == touchedBy_) {
-            touch(0);
+            touch(noLabel);
         }
     }
     
     bool FloorObject::quadIntersects(vector<ofVec3f> quad){
-        ofPolyline polygon;
-        polygon.addVertices(quad_);
         for (int i = 0; i < quad.size(); i++) {
-            if (polygon.inside(quad[0]) || polygon.inside(quad[1]) || polygon.inside(quad[2]) || polygon.inside(quad[3]) ) {
+            if (quadContains(quad_, quad[i].x, quad[i].y)) {
                 return true;
             }
         }
@@ -100,275 +113,685 @@ namespace ofxKinectObjects {
      OBJECT TRACKER
      **___________________________________*/
     
+    //Contours and bounding boxes, as ofxCv::ContourFinder::draw()
+    static void drawBlobs(const vector<TrackedBlob>& blobs){
+        ofPushStyle();
+        ofNoFill();
+        for (int i = 0; i < blobs.size(); ++i) {
+            ofPolyline contour = blobs[i].contour;
+            contour.draw();
+            ofRect(blobs[i].boundingRect);
+        }
+        ofPopStyle();
+    }
+    
+    static void fillState(const TrackedBlob& blob, HandState& state){
+        state.label = blob.label;
+        state.sensor = blob.sensor;
+        state.centroid = blob.centroid;
+        state.quad = blob.quad;
+        state.worldCentroid = blob.worldCentroid;
+        state.worldQuad = blob.worldQuad;
+        state.minHeight = blob.minHeight;
+        state.maxHeight = blob.maxHeight;
+        state.meanHeight = blob.meanHeight;
+        state.area = blob.worldQuad[0].distance(blob.worldQuad[1]) + blob.worldQuad[1].distance(blob.worldQuad[2]);
+    }
+    
+    Sensor::Sensor(){
+        frameNumber = 0;
+        trackedFrameNumber = 0;
+        bObjectsImageDirty = bHandsImageDirty = false;
+        drawX = drawY = drawW = drawH = 0;
+        bCalibratingBackground = false;
+        bAutoCalibratingBackground = false;
+        autoCalibrationFrames = 60;
+        segmenter = shared_ptr<DepthSegmenter>(new DepthSegmenter());
+        bAutoCalibratingPlane = false;
+        planeFitTime = lastPlaneCheck = 0;
+        planeCheckRatio = 0;
+    }
+    
     ObjectTracker::ObjectTracker(){
-        
+        bPipelined_ = false;
+        bHeadless_ = false;
+        drawDetectors_ = true;
+        objectsDecimation_ = handsDecimation_ = 1;
+        objectsInterval_ = 1;
+        objectsChangeArea_ = 0;
+        frameBudget_ = 0;
+        tileSize_ = 0;
+        changeThreshold_ = 10;
+        bSinglePassLabeling_ = false;
+        planeCheckInterval_ = 0;
+        minPlaneInlierRatio_ = 0.5;
+        bPlaneRefit_ = true;
+        bPerHandEvents_ = true;
+    #ifdef OFX_KINECT_OBJECTS_STATS
+        bDrawStats_ = false;
+    #endif
     }
-
-    void ObjectTracker::setup(){
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::setPipelined(bool pipelined){
+        bPipelined_ = pipelined;
+    }
+    
+    bool ObjectTracker::isPipelined(){
+        return bPipelined_;
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::setPerHandEvents(bool perHandEvents){
+        bPerHandEvents_ = perHandEvents;
+    }
+    
+    bool ObjectTracker::getPerHandEvents(){
+        return bPerHandEvents_;
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::setHeadless(bool headless){
+        bHeadless_ = headless;
+    }
+    
+    bool ObjectTracker::isHeadless(){
+        return bHeadless_;
+    }
+    
+    void ObjectTracker::setup(int numSensors){
+        vector<shared_ptr<DepthSource> > sources;
+        for (int i = 0; i < numSensors; i++) {
+            sources.push_back(shared_ptr<DepthSource>(new KinectSource(i)));
+        }
+        setup(sources);
+    }
+    
+    void ObjectTracker::setup(vector<shared_ptr<DepthSource> > sources){
+        int numSensors = sources.size();
+        
         //add listener to mousePressed event
         ofAddListener(ofEvents().mousePressed, this, &ObjectTracker::mousePressed);
         
-        // enable depth->video image calibration
-        kinect.setRegistration(true);
+        // one core per sensor, so N sensors take as long as one
+        if (numSensors > 1 && !bPipelined_) {
+            ofLogNotice("ObjectTracker") << "setup(): " << numSensors << " sensors, enabling pipelined mode";
+            bPipelined_ = true;
+        }
         
-        //kinect.init();
-        //kinect.init(true); // shows infrared instead of RGB video image
-        kinect.init(false, false); // disable video image (faster fps)
+        sensors.clear();
+        for (int i = 0; i < numSensors; i++) {
+            shared_ptr<Sensor> sensor(new Sensor());
+            sensor->source = sources[i];
+            DepthSource& source = *sensor->source;
+            if (!source.setup()) {
+                ofLogWarning("ObjectTracker") << "setup(): sensor " << i << " did not open";
+            }
+            
+            // detector images are allocated and uploaded on first draw
+            sensor->segmenter->setup(source.getWidth(), source.getHeight());
+            sensor->backgroundModel.setup(source.getWidth(), source.getHeight());
+            sensor->touchIndex.setup(source.getWidth(), source.getHeight());
+            
+            // segmentation and contour finding on a worker thread
+            if (bPipelined_) {
+                sensor->pipelineThread.setup(&sensor->pipeline, &sensor->depthFrames, &sensor->trackingFrames);
+                sensor->pipelineThread.start();
+            }
+            
+            sensors.push_back(sensor);
+        }
         
-        kinect.open();		// opens first available kinect
-        //kinect.open(1);	// open a kinect by id, starting with 0 (sorted by serial # lexicographically))
-        //kinect.open("A00362A08602047A");	// open a kinect using it's unique serial #
+        // transforms set before setup() are kept
+        sensorTransforms.resize(numSensors);
+        sensorFrames.resize(numSensors);
+        sensorFramesNew.resize(numSensors);
+        fusion.setup(numSensors);
         
-        // print the intrinsic IR sensor values
-        if(kinect.isConnected()) {
-            ofLogNotice() << "sensor-emitter dist: " << kinect.getSensorEmitterDistance() << "cm";
-            ofLogNotice() << "sensor-camera dist:  " << kinect.getSensorCameraDistance() << "cm";
-            ofLogNotice() << "zero plane pixel size: " << kinect.getZeroPlanePixelSize() << "mm";
-            ofLogNotice() << "zero plane dist: " << kinect.getZeroPlaneDistance() << "mm";
+        ofSetFrameRate(60);
+    }
+    
+    //--------------------------------------------------------------
+    int ObjectTracker::getNumSensors(){
+        return sensors.size();
+    }
+    
+    void ObjectTracker::setSensorTransform(int sensor, ofMatrix4x4 toTable){
+        if (sensor < 0) {
+            ofLogError("ObjectTracker") << "setSensorTransform(): no sensor " << sensor;
+            return;
+        }
+        if (sensor >= sensorTransforms.size()) {
+            sensorTransforms.resize(sensor + 1);
+        }
+        sensorTransforms[sensor] = toTable;
+    }
+    
+    void ObjectTracker::setMergeDistance(float distance){
+        fusion.setMergeDistance(distance);
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::updateSensor(Sensor& sensor){
+        DepthSource& source = *sensor.source;
+        {
+            ScopedStageTimer timer(frameTimes, STAGE_KINECT);
+            source.update();
         }
         
-    #ifdef USE_TWO_KINECTS
-        kinect2.init();
-        kinect2.open();
-    #endif
-
-        objectsImage.allocate(kinect.width, kinect.height, OF_IMAGE_GRAYSCALE);
-        handsImage.allocate(kinect.width, kinect.height, OF_IMAGE_GRAYSCALE);
-                
-        ofSetFrameRate(60);
+        // there is a new frame and we are connected
+        if(!source.isFrameNew()) {
+            return;
+        }
         
-        kinectX = kinectY = kinectW = kinectH = 0;
+        if (!sensor.segmenter->hasRays()) {
+            shared_ptr<DepthSegmenter> withRays(new DepthSegmenter(*sensor.segmenter));
+            withRays->setRays(source);
+            sensor.segmenter = withRays;
+        }
         
-        // zero the tilt on startup
-        kinect.setCameraTiltAngle(0);
+        const unsigned short* depth = source.getDepthPixels();
         
-        bCalibratingBackground = false;
+        if (sensor.recorder.isRecording()) {
+            sensor.recorder.addFrame(depth, source.getTimestamp());
+        }
+        
+        if (sensor.bAutoCalibratingBackground) {
+            sensor.backgroundModel.addFrame(depth);
+            if (sensor.backgroundModel.getFrameCount() >= sensor.autoCalibrationFrames) {
+                sensor.bAutoCalibratingBackground = false;
+                applyBackgroundModel(sensor);
+            }
+        }
+        updatePlane(sensor, depth);
+        
+        DetectionSettings settings;
+        settings.floorThreshold = floorThreshold_;
+        settings.handsThreshold = handsThreshold_;
+        settings.objectsBlobSize = objectsBlobSize_;
+        settings.handsBlobSize = handsBlobSize_;
+        settings.objectsDecimation = objectsDecimation_;
+        settings.handsDecimation = handsDecimation_;
+        settings.objectsInterval = objectsInterval_;
+        settings.objectsChangeArea = objectsChangeArea_;
+        settings.frameBudget = frameBudget_;
+        settings.tileSize = tileSize_;
+        settings.changeThreshold = changeThreshold_;
+        settings.singlePassLabeling = bSinglePassLabeling_;
+        settings.keepMasks = !bHeadless_ && drawDetectors_;
         
+        sensor.frameNumber++;
+        
+        if (bPipelined_) {
+            // hand the frame over to the worker and carry on
+            DepthFrame& input = sensor.depthFrames.getBack();
+            {
+                ScopedStageTimer timer(frameTimes, STAGE_KINECT);
+                input.depth.assign(depth, depth + source.getWidth() * source.getHeight());
+            }
+            input.segmenter = sensor.segmenter;
+            input.settings = settings;
+            input.frameNumber = sensor.frameNumber;
+            sensor.depthFrames.publish();
+            sensor.pipelineThread.notifyFrame();
+        } else {
+            TrackingFrame& output = sensor.trackingFrames.getBack();
+            sensor.pipeline.process(depth, *sensor.segmenter, settings, output);
+            output.frameNumber = sensor.frameNumber;
+            sensor.trackingFrames.publish();
+        }
     }
-
+    
     void ObjectTracker::update(){
-        kinect.update();
+        frameTimes.clear();
+        {
+            ScopedStageTimer timer(frameTimes, STAGE_UPDATE);
+            updateTracking();
+        }
         
-        // there is a new frame and we are connected
-        if(kinect.isFrameNew()) {
-            
-            // load grayscale depth image from the kinect source
-            //grayImage.setFromPixels(kinect.getDepthPixels(), kinect.width, kinect.height);
-            
-            // or we do it ourselves - show people how they can work with the pixels
-            ofPixelsRef objPixels = objectsImage.getPixelsRef();
-            ofPixelsRef handsPixels = handsImage.getPixelsRef();
-            
-            for(int i = 0; i < kinect.getWidth(); i++) {
-                for (int j = 0; j < kinect.getHeight(); j++) {
-                    //OBJECTS ON THE FLOOR
-                    if (ofInRange(distanceToBackground(i, j), floorThreshold_.x, floorThreshold_.y)){
-                        objPixels.setColor(i, j, 255);
-                        handsPixels.setColor(i, j, 0);
-                        //HANDS ON OBJECTS
-                    } else if (ofInRange(distanceToBackground(i, j), handsThreshold_.x, handsThreshold_.y)){
-                        objPixels.setColor(i, j, 0);
-                        handsPixels.setColor(i, j, 255);
-                    } else {
-                        objPixels.setColor(i, j, 0);
-                        handsPixels.setColor(i, j, 0);
-                    }
-                }
+    #ifdef OFX_KINECT_OBJECTS_STATS
+        stats.addTimes(frameTimes);
+        stats.setCounts(snapshot.objects.size(), snapshot.hands.size());
+        stats.dumpIfDue();
+    #endif
+    }
+    
+    void ObjectTracker::updateTracking(){
+        for (int s = 0; s < sensors.size(); s++) {
+            updateSensor(*sensors[s]);
+        }
+        
+        // latest tracking result of every sensor, from the workers or from above
+        bool bNew = false;
+        for (int s = 0; s < sensors.size(); s++) {
+            Sensor& sensor = *sensors[s];
+            sensorFramesNew[s] = sensor.trackingFrames.consume();
+            sensorFrames[s] = &sensor.trackingFrames.getFront();
+            if (sensorFramesNew[s]) {
+                // the images we draw are uploaded only if drawn
+                sensor.bObjectsImageDirty = sensor.bHandsImageDirty = true;
+                bNew = true;
+                
+            #ifdef OFX_KINECT_OBJECTS_STATS
+                // frame numbers skipped were dropped by a busy worker
+                stats.addTimes(sensorFrames[s]->times);
+                stats.addFrame(sensorFrames[s]->frameNumber - sensor.trackedFrameNumber - 1, sensorFrames[s]->bObjectsRefreshed, sensorFrames[s]->bObjectsShed);
+            #endif
+                sensor.trackedFrameNumber = sensorFrames[s]->frameNumber;
             }
-            
-            // update the cv images
-            objectsImage.setFromPixels(objPixels);
-            objectsImage.update();
-            handsImage.setFromPixels(handsPixels);
-            handsImage.update();
-            
-            // find contours which are between the size of 20 pixels and 1/3 the w*h pixels.
-            // also, find holes is set to true so we will get interior contours as well....
-            objectsFinder.setMinArea(objectsBlobSize_.x);
-            objectsFinder.setMaxArea(objectsBlobSize_.y);
-            objectsFinder.findContours(objectsImage);
-            
-            handsFinder.setMinArea(handsBlobSize_.x);
-            handsFinder.setMaxArea(handsBlobSize_.y);
-            handsFinder.findContours(handsImage);
+        }
+        if (!bNew) {
+            return;
         }
         
-    #ifdef USE_TWO_KINECTS
-        kinect2.update();
-    #endif
+        // one table, one label per object and per hand
+        {
+            ScopedStageTimer timer(frameTimes, STAGE_FUSION);
+            fusion.fuse(sensorFrames, sensorFramesNew, sensorTransforms, fused);
+        }
+        const FusedFrame& frame = fused;
         
-        //TODO is this efficient / smart???
-        vector<unsigned int> objectIds;
+        updateObjects(frame);
         
-        for (int i = 0; i < objectsFinder.size(); ++i) {
-            objectIds.push_back(objectsFinder.getLabel(i));
-
+        ScopedStageTimer timer(frameTimes, STAGE_EVENTS);
+        
+        if (bPerHandEvents_) {
+            for (int i = 0; i < frame.hands.size(); ++i) {
+                static HandOnEvent newEvent;
+                newEvent.quad = frame.hands[i].quad;
+                newEvent.handLabel = frame.hands[i].label;
+                ofNotifyEvent(HandOnEvent::events, newEvent);
+            }
             
-            vector<cv::Point> quad = objectsFinder.getFitQuad(i);
-            float currentArea = kinect.getWorldCoordinateAt(quad[0].x, quad[0].y).distance(kinect.getWorldCoordinateAt(quad[1].x, quad[1].y))
-            + kinect.getWorldCoordinateAt(quad[1].x, quad[1].y).distance(kinect.getWorldCoordinateAt(quad[2].x, quad[2].y));
+            for (int i = 0; i < frame.deadHandLabels.size(); i++){
+                static HandOutEvent newEvent;
+                newEvent.handLabel = frame.deadHandLabels[i];
+                ofNotifyEvent(HandOutEvent::events, newEvent);
+            }
+        }
+        
+        frameEvent.frameNumber = snapshot.frameNumber;
+        frameEvent.objects = &snapshot.objects;
+        frameEvent.hands = &snapshot.hands;
+        frameEvent.touches = &touches;
+        frameEvent.predictions = &predictions;
+        frameEvent.deadObjectLabels = &frame.deadObjectLabels;
+        frameEvent.deadHandLabels = &frame.deadHandLabels;
+        ofNotifyEvent(FrameTrackedEvent::events, frameEvent);
+        
+        publisher.publish(snapshot);
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::updateObjects(const FusedFrame& frame){
+        ScopedStageTimer timer(frameTimes, STAGE_BOOKKEEPING);
+        touches.clear();
+        predictions.clear();
+        
+        // geometry of this result, computed once for update and draw
+        snapshot.frameNumber = frame.frameNumber;
+        snapshot.objects.resize(frame.objects.size());
+        for (int i = 0; i < frame.objects.size(); ++i) {
+            fillState(frame.objects[i], snapshot.objects[i]);
+        }
+        snapshot.hands.resize(frame.hands.size());
+        for (int i = 0; i < frame.hands.size(); ++i) {
+            fillState(frame.hands[i], snapshot.hands[i]);
+        }
+        
+        for (int i = 0; i < frame.objects.size(); ++i) {
+            const TrackedBlob& blob = frame.objects[i];
+            float currentArea = snapshot.objects[i].area;
             
+            FloorObject* object = objects.find(blob.label);
             //Object already exists
-            if (objects.find(objectsFinder.getLabel(i)) != objects.end()) {
+            if (object) {
                 //update object
                 //update area if bigger
-                if (currentArea > objects[objectsFinder.getLabel(i)]->getArea()) {
-                    objects[objectsFinder.getLabel(i)]->setArea(currentArea);
+                if (currentArea > object->getArea()) {
+                    object->setArea(currentArea);
                 }
-                objects[objectsFinder.getLabel(i)]->setQuad(ofxCvPointQuadToOfPointQuad(objectsFinder.getFitQuad(i)));
+                object->setQuad(blob.quad);
             }
             //object doesn't exist
             else {
                 //insert new object
-                FloorObject* newObject = new FloorObject(currentArea, kinect.getWorldCoordinateAt(objectsFinder.getCentroid(i).x, objectsFinder.getCentroid(i).y), ofxCvPointQuadToOfPointQuad(objectsFinder.getFitQuad(i)));
-                objects[objectsFinder.getLabel(i)] = newObject;
+                objects.insert(blob.label, FloorObject(currentArea, blob.worldCentroid, blob.quad));
             }
             
             //Choose category
-            selectCategory(objectsFinder.getLabel(i));
+            categorize(blob, frame.frameNumber);
         }
         
-        //Eliminate unpresent objects
-        map<unsigned int, FloorObject*>::iterator it = objects.begin();
-        while (it != objects.end()) {
-            if (find(objectIds.begin(), objectIds.end(), it->first) == objectIds.end() ) {
-                objects.erase(it++);
-            } else {
-                ++it;
+        //Eliminate objects the trackers gave up on
+        for (int i = 0; i < frame.deadObjectLabels.size(); i++) {
+            FloorObject* object = objects.find(frame.deadObjectLabels[i]);
+            if (object && object->isTouched()) {
+                notifyTouch(frame.deadObjectLabels[i], object->getTouchedBy(), false);
             }
         }
+        objects.erase(frame.deadObjectLabels);
+        categorizer.erase(frame.deadObjectLabels);
         
-        for (int i = 0; i < handsFinder.size(); ++i) {
-            static HandOnEvent newEvent;
-            newEvent.quad = ofxCvPointQuadToOfPointQuad(handsFinder.getFitQuad(i));
-            newEvent.handLabel = handsFinder.getLabel(i);
-            ofNotifyEvent(HandOnEvent::events, newEvent);
+        resolveTouches(frame);
+        if (predictor.isEnabled()) {
+            predictTouches(frame);
         }
         
-        for (int i = 0; i < handsFinder.getTracker().getDeadLabels().size(); i++){
-            static HandOutEvent newEvent;
-            newEvent.handLabel = handsFinder.getTracker().getDeadLabels()[i];
-            ofNotifyEvent(HandOutEvent::events, newEvent);
+        for (int i = 0; i < snapshot.objects.size(); ++i) {
+            FloorObject* object = objects.find(snapshot.objects[i].label);
+            if (object) {
+                snapshot.objects[i].category = object->getCategory();
+                snapshot.objects[i].touchedBy = object->getTouchedBy();
+            }
+        }
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::resolveTouches(const FusedFrame& frame){
+        // hands touch objects in the pixels of the sensor that sees both
+        for (int s = 0; s < sensors.size(); s++) {
+            sensors[s]->touchIndex.clear();
+        }
+        for (int i = 0; i < frame.objectViews.size(); ++i) {
+            sensors[frame.objectViews[i].sensor]->touchIndex.add(i, frame.objectViews[i].quad);
+        }
+        
+        // For each object: first hand on it in any view, and whether the hand
+        // touching it still is
+        objectRows.clear();
+        for (int i = 0; i < frame.objects.size(); ++i) {
+            objectRows[frame.objects[i].label] = i;
+        }
+        firstHands.assign(frame.objects.size(), noLabel);
+        touchedByStillOn.assign(frame.objects.size(), false);
+        for (int h = 0; h < frame.handViews.size(); ++h) {
+            unsigned int handLabel = frame.handViews[h].label;
+            sensors[frame.handViews[h].sensor]->touchIndex.query(frame.handViews[h].quad, touchHits);
+            for (int k = 0; k < touchHits.size(); k++) {
+                int o = objectRows[frame.objectViews[touchHits[k]].label];
+                if (firstHands[o] == noLabel) {
+                    firstHands[o] = handLabel;
+                }
+                FloorObject* object = objects.find(frame.objects[o].label);
+                if (object && object->getTouchedBy() == handLabel) {
+                    touchedByStillOn[o] = true;
+                }
+            }
+        }
+        
+        for (int o = 0; o < frame.objects.size(); ++o) {
+            FloorObject* object = objects.find(frame.objects[o].label);
+            if (!object) {
+                continue;
+            }
+            unsigned int current = object->getTouchedBy();
+            unsigned int next = current;
+            
+            // TOUCHED
+            //    - hand gone --> untouch
+            //    - same hand seen off the object --> untouch
+            //    - same hand not seen this frame --> nothing
+            if (current != noLabel) {
+                bool dead = find(frame.deadHandLabels.begin(), frame.deadHandLabels.end(), current) != frame.deadHandLabels.end();
+                bool present = false;
+                for (int h = 0; h < frame.hands.size() && !present; ++h) {
+                    present = frame.hands[h].label == current;
+                }
+                if (dead || (present && !touchedByStillOn[o])) {
+                    next = noLabel;
+                }
+            }
+            // NOT TOUCHED
+            //    - first hand on it --> touch
+            if (next == noLabel) {
+                next = firstHands[o];
+            }
+            
+            if (next != current) {
+                object->touch(next);
+                if (current != noLabel) {
+                    notifyTouch(frame.objects[o].label, current, false);
+                }
+                if (next != noLabel) {
+                    notifyTouch(frame.objects[o].label, next, true);
+                }
+            }
+        }
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::notifyTouch(unsigned int objectLabel, unsigned int handLabel, bool touched){
+        touches.push_back(TouchEvent());
+        TouchEvent& newEvent = touches.back();
+        newEvent.objectLabel = objectLabel;
+        newEvent.handLabel = handLabel;
+        newEvent.touched = touched;
+        if (touched) {
+            predictor.confirm(objectLabel, handLabel);
+        }
+        if (bPerHandEvents_) {
+            TouchEvent copy = newEvent;
+            ofNotifyEvent(TouchEvent::events, copy);
+        }
+    }
+    
+    //--------------------------------------------------------------
+    // Each hand where its filter puts it after the look-ahead, against the
+    // objects resolveTouches() indexed. Only pairs that don't touch yet.
+    void ObjectTracker::predictTouches(const FusedFrame& frame){
+        predictor.updateHands(frame.hands, frame.deadHandLabels, frame.frameNumber);
+        predictedPairs.clear();
+        for (int h = 0; h < frame.hands.size(); ++h) {
+            unsigned int handLabel = frame.hands[h].label;
+            if (!predictor.predictQuad(frame.hands[h], predictedQuad)) {
+                continue;
+            }
+            sensors[frame.hands[h].sensor]->touchIndex.query(predictedQuad, touchHits);
+            for (int k = 0; k < touchHits.size(); k++) {
+                pair<unsigned int, unsigned int> predicted(frame.objectViews[touchHits[k]].label, handLabel);
+                FloorObject* object = objects.find(predicted.first);
+                if (!object || object->getTouchedBy() == handLabel || find(predictedPairs.begin(), predictedPairs.end(), predicted) != predictedPairs.end()) {
+                    continue;
+                }
+                predictedPairs.push_back(predicted);
+            }
+        }
+        predictor.updatePairs(predictedPairs, frame.deadObjectLabels, frame.deadHandLabels, predictions);
+        
+        if (bPerHandEvents_) {
+            for (int i = 0; i < predictions.size(); i++) {
+                TouchPredictedEvent copy = predictions[i];
+                ofNotifyEvent(TouchPredictedEvent::events, copy);
+            }
         }
     }
     
     //--------------------------------------------------------------
-    void ObjectTracker::drawObjectDetector(int x, int y, int w, int h){
+    void ObjectTracker::drawObjectDetector(int x, int y, int w, int h, int s){
+        Sensor& sensor = *sensors[s];
+        const TrackingFrame& frame = sensor.trackingFrames.getFront();
+        
         //OBJECTS
         //Image
         ofSetColor(0, 255, 0);
-        objectsImage.draw(x, y, w, h);
+        if (sensor.bObjectsImageDirty && !frame.objectsMask.empty()) {
+            sensor.objectsImage.setFromPixels(frame.objectsMask.data, frame.objectsMask.cols, frame.objectsMask.rows, OF_IMAGE_GRAYSCALE);
+            sensor.bObjectsImageDirty = false;
+        }
+        if (sensor.objectsImage.isAllocated()) {
+            sensor.objectsImage.draw(x, y, w, h);
+        }
         
         //Detector
         ofPushMatrix();
         ofSetLineWidth(2);
         ofSetColor(0, 0, 255);
         ofTranslate(x, y);
-        ofScale(w/float(kinect.width), h/float(kinect.height));
-        objectsFinder.draw();
+        ofScale(w/float(sensor.source->getWidth()), h/float(sensor.source->getHeight()));
+        drawBlobs(frame.objects);
         ofPopMatrix();
         
-        for (int i = 0; i < objectsFinder.size(); ++i) {
-            vector<cv::Point> quads = objectsFinder.getFitQuad(i);
-            
-            float realArea = kinect.getWorldCoordinateAt(quads[0].x, quads[0].y).distance(kinect.getWorldCoordinateAt(quads[1].x, quads[1].y))
-            + kinect.getWorldCoordinateAt(quads[1].x, quads[1].y).distance(kinect.getWorldCoordinateAt(quads[2].x, quads[2].y));
+        for (int i = 0; i < snapshot.objects.size(); ++i) {
+            const ObjectState& object = snapshot.objects[i];
+            if (object.sensor != s) {
+                continue;
+            }
             
-            float x_obj = ofMap(objectsFinder.getCentroid(i).x, 0, objectsImage.width, x, x+w);
-            float y_obj = ofMap(objectsFinder.getCentroid(i).y, 0, objectsImage.height, y, y+h);
+            float x_obj = ofMap(object.centroid.x, 0, sensor.source->getWidth(), x, x+w);
+            float y_obj = ofMap(object.centroid.y, 0, sensor.source->getHeight(), y, y+h);
             
-            if (objects[objectsFinder.getLabel(i)]->isTouched()) {
+            if (object.isTouched()) {
                 ofSetColor(ofColor::yellow);
                 ofCircle(x_obj, y_obj, 4);
                 ofSetColor(0, 0, 255);
             }
-            ofDrawBitmapString(ofToString(realArea), x_obj, y_obj);
+            ofDrawBitmapString(ofToString(object.area), x_obj, y_obj);
         }
         
         ofSetColor(255, 255, 255);
     }
     
     //--------------------------------------------------------------
-    void ObjectTracker::drawHandsDetector(int x, int y, int w, int h){
+    void ObjectTracker::drawHandsDetector(int x, int y, int w, int h, int s){
+        Sensor& sensor = *sensors[s];
+        const TrackingFrame& frame = sensor.trackingFrames.getFront();
+        
         //HANDS
         //Image
         ofSetColor(255, 0, 0);
-        handsImage.draw(x, y, w, h);
+        if (sensor.bHandsImageDirty && !frame.handsMask.empty()) {
+            sensor.handsImage.setFromPixels(frame.handsMask.data, frame.handsMask.cols, frame.handsMask.rows, OF_IMAGE_GRAYSCALE);
+            sensor.bHandsImageDirty = false;
+        }
+        if (sensor.handsImage.isAllocated()) {
+            sensor.handsImage.draw(x, y, w, h);
+        }
         
         //Detector
         ofPushMatrix();
         ofSetLineWidth(2);
         ofSetColor(0, 0, 255);
         ofTranslate(x, y);
-        ofScale(w/float(kinect.width), h/float(kinect.height));
-        handsFinder.draw();
+        ofScale(w/float(sensor.source->getWidth()), h/float(sensor.source->getHeight()));
+        drawBlobs(frame.hands);
         ofPopMatrix();
         
-        for (int i = 0; i < handsFinder.size(); ++i) {
-            vector<cv::Point> quads = handsFinder.getFitQuad(i);
-            
-            float realArea = kinect.getWorldCoordinateAt(quads[0].x, quads[0].y).distance(kinect.getWorldCoordinateAt(quads[1].x, quads[1].y))
-            + kinect.getWorldCoordinateAt(quads[1].x, quads[1].y).distance(kinect.getWorldCoordinateAt(quads[2].x, quads[2].y));
+        for (int i = 0; i < snapshot.hands.size(); ++i) {
+            const HandState& hand = snapshot.hands[i];
+            if (hand.sensor != s) {
+                continue;
+            }
             
-            float x_hand = ofMap(handsFinder.getCentroid(i).x, 0, handsImage.width, x, x+w);
-            float y_hand = ofMap(handsFinder.getCentroid(i).y, 0, handsImage.width, y, y+h);
+            float x_hand = ofMap(hand.centroid.x, 0, sensor.source->getWidth(), x, x+w);
+            float y_hand = ofMap(hand.centroid.y, 0, sensor.source->getHeight(), y, y+h);
             
-            ofDrawBitmapString(ofToString(realArea), x_hand, y_hand);
+            ofDrawBitmapString(ofToString(hand.area), x_hand, y_hand);
         }
         ofSetColor(255, 255, 255);
     }
     
     //--------------------------------------------------------------
-    void ObjectTracker::drawInput(int x, int y, int w, int h){
-        // draw from the live kinect
-        kinect.drawDepth(x, y, w, h);
-        kinectX = x;
-        kinectY = y;
-        kinectW = w;
-        kinectH = h;
-        int kinectMouseX = ofMap(ofGetMouseX(), x, x+w, 0, kinect.getWidth());
-        int kinectMouseY = ofMap(ofGetMouseY(), y, y+h, 0, kinect.getHeight());
+    void ObjectTracker::drawInput(int x, int y, int w, int h, int s){
+        Sensor& sensor = *sensors[s];
+        DepthSource& source = *sensor.source;
+        
+        // draw from the depth source
+        source.drawDepth(x, y, w, h);
+        sensor.drawX = x;
+        sensor.drawY = y;
+        sensor.drawW = w;
+        sensor.drawH = h;
+        int kinectMouseX = ofMap(ofGetMouseX(), x, x+w, 0, source.getWidth());
+        int kinectMouseY = ofMap(ofGetMouseY(), y, y+h, 0, source.getHeight());
         ofSetColor(255, 0, 0);
         
         //Info over mouse
-        if (isBgCalibrated() && ofGetMouseX() > x && ofGetMouseX() < x+w && ofGetMouseY() > y && ofGetMouseY() < y+h){
-            ofDrawBitmapString(ofToString(distanceToBackground(kinectMouseX, kinectMouseY)), ofGetMouseX(), ofGetMouseY());
+        if (sensor.segmenter->isReady() && ofGetMouseX() > x && ofGetMouseX() < x+w && ofGetMouseY() > y && ofGetMouseY() < y+h){
+            ofDrawBitmapString(ofToString(distanceToBackground(sensor, kinectMouseX, kinectMouseY)), ofGetMouseX(), ofGetMouseY());
         }
         else if (ofGetMouseX() > x && ofGetMouseX() < x+w && ofGetMouseY() > y && ofGetMouseY() < y+h){
-            ofDrawBitmapString(ofToString(kinect.getWorldCoordinateAt(kinectMouseX, kinectMouseY)), ofGetMouseX(), ofGetMouseY());
+            ofDrawBitmapString(ofToString(source.getWorldCoordinateAt(kinectMouseX, kinectMouseY)), ofGetMouseX(), ofGetMouseY());
         }
         ofSetColor(255, 255, 255);
         
-#ifdef USE_TWO_KINECTS
-        kinect2.draw(420, 320, 400, 300);
-#endif
+    #ifdef OFX_KINECT_OBJECTS_STATS
+        if (bDrawStats_ && s == 0) {
+            drawStats(x + w + 10, y + 10);
+        }
+    #endif
+    }
+    
+    const FrameSnapshot& ObjectTracker::getSnapshot() const{
+        return snapshot;
+    }
+    
+#ifdef OFX_KINECT_OBJECTS_STATS
+    //--------------------------------------------------------------
+    const TrackerStats& ObjectTracker::getStats() const{
+        return stats;
     }
     
+    void ObjectTracker::resetStats(){
+        stats.reset();
+    }
+    
+    void ObjectTracker::setDrawStats(bool drawStats){
+        bDrawStats_ = drawStats;
+    }
+    
+    void ObjectTracker::drawStats(int x, int y){
+        ofSetColor(255, 255, 255);
+        stats.draw(x, y);
+    }
+    
+    void ObjectTracker::setStatsDump(string path, float interval){
+        stats.setDump(path, interval);
+    }
+#endif
+    
+    //--------------------------------------------------------------
     bool ObjectTracker::isBgCalibrated(){
-        return backgroundPoints.size() == 3;
+        for (int s = 0; s < sensors.size(); s++) {
+            if (!sensors[s]->segmenter->isReady()) {
+                return false;
+            }
+        }
+        return !sensors.empty();
     }
     
     //--------------------------------------------------------------
     void ObjectTracker::exit(){
-        kinect.setCameraTiltAngle(0); // zero the tilt on exit
-        kinect.close();
+        ofRemoveListener(ofEvents().mousePressed, this, &ObjectTracker::mousePressed);
         
-    #ifdef USE_TWO_KINECTS
-        kinect2.close();
-    #endif
+        for (int s = 0; s < sensors.size(); s++) {
+            if (bPipelined_) {
+                sensors[s]->pipelineThread.stop();
+            }
+            
+            sensors[s]->recorder.stop();
+            sensors[s]->source->close();
+        }
+        
+        publisher.close();
     }
-
+    
     //--------------------------------------------------------------
-    float ObjectTracker::distanceToBackground(int kinectMouseX, int kinectMouseY){
-        ofVec3f p = kinect.getWorldCoordinateAt(kinectMouseX, kinectMouseY);
+    float ObjectTracker::distanceToBackground(Sensor& sensor, int kinectMouseX, int kinectMouseY){
+        unsigned short depth = sensor.source->getDepthPixels()[kinectMouseY * sensor.source->getWidth() + kinectMouseX];
         
-        return abs(background_n.dot(p-background_v0));
+        return sensor.segmenter->getDistanceToBackground(depth, kinectMouseX, kinectMouseY);
     }
     
     //--------------------------------------------------------------
     void ObjectTracker::setKinectAngle(int angle){
-        if(kinect.hasCamTiltControl()) {
-            kinect.setCameraTiltAngle(angle);
+        for (int s = 0; s < sensors.size(); s++) {
+            sensors[s]->source->setTiltAngle(angle);
+            //The table moved in view: fit it again once the motor is done
+            if (sensors[s]->plane.bValid) {
+                sensors[s]->bAutoCalibratingPlane = true;
+                sensors[s]->planeFitTime = ofGetElapsedTimef() + tiltSeconds;
+            }
         }
     }
     
@@ -381,36 +804,305 @@ namespace ofxKinectObjects {
         drawDetectors_ = drawDetectors;
     }
     
+    void ObjectTracker::setDecimation(int objectsDecimation, int handsDecimation){
+        if ((objectsDecimation != 1 && objectsDecimation != 2 && objectsDecimation != 4) || (handsDecimation != 1 && handsDecimation != 2 && handsDecimation != 4)) {
+            ofLogError("ObjectTracker") << "setDecimation(): " << objectsDecimation << ", " << handsDecimation << " not 1, 2 or 4";
+            return;
+        }
+        objectsDecimation_ = objectsDecimation;
+        handsDecimation_ = handsDecimation;
+    }
+    
+    void ObjectTracker::setObjectsSchedule(int interval, float changeArea){
+        objectsInterval_ = MAX(interval, 1);
+        objectsChangeArea_ = MAX(changeArea, 0.f);
+    }
+    
+    void ObjectTracker::setFrameBudget(float micros){
+        frameBudget_ = MAX(micros, 0.f);
+    }
+    
+    void ObjectTracker::setIncrementalSegmentation(int tileSize, float changeThreshold){
+        tileSize_ = MAX(tileSize, 0);
+        changeThreshold_ = MAX(changeThreshold, 0.f);
+    }
+    
+    void ObjectTracker::setSinglePassLabeling(bool singlePassLabeling){
+        bSinglePassLabeling_ = singlePassLabeling;
+    }
+    
+    void ObjectTracker::setTouchPrediction(float lookAhead, int onFrames, int offFrames){
+        predictor.setLookAhead(lookAhead);
+        predictor.setHysteresis(onFrames, offFrames);
+        if (!predictor.isEnabled()) {
+            predictor.clear();
+        }
+    }
+    
     //--------------------------------------------------------------
+    //Without a category table: small or big
     void ObjectTracker::selectCategory(unsigned int _label){
-        //TODO implement categories logic
-        if (objects[_label]->getArea() < 50) {
-            objects[_label]->setCategory(1);
+        FloorObject* object = objects.find(_label);
+        if (!object) {
+            return;
+        }
+        if (object->getArea() < 50) {
+            object->setCategory(1);
+        } else {
+            object->setCategory(2);
+        }
+    }
+    
+    // From the pixels of the object in the latest depth of the sensor that sees
+    // it, until its category freezes. When pipelined the depth can be a frame
+    // newer than the quad, which objects standing still don't mind.
+    void ObjectTracker::categorize(const TrackedBlob& blob, unsigned long long frameNumber){
+        if (!categorizer.hasCategories()) {
+            selectCategory(blob.label);
+            return;
+        }
+        if (!categorizer.needsSample(blob.label, frameNumber)) {
+            return;
+        }
+        Sensor& sensor = *sensors[blob.sensor];
+        DepthSource& source = *sensor.source;
+        float pixelSize = 2 * source.getZeroPlanePixelSize() / source.getZeroPlaneDistance();
+        ObjectSample sample;
+        FloorObject* object = objects.find(blob.label);
+        if (object && Categorizer::measure(source.getDepthPixels(), *sensor.segmenter, blob.quad, blob.worldQuad, floorThreshold_.x, pixelSize, sample)) {
+            object->setCategory(categorizer.addSample(blob.label, frameNumber, sample));
+        }
+    }
+    
+    bool ObjectTracker::loadCategories(string path){
+        if (!categorizer.load(path)) {
+            return false;
+        }
+        clearCategories();
+        return true;
+    }
+    
+    void ObjectTracker::setCategories(const vector<ObjectCategory>& categories){
+        categorizer.setCategories(categories);
+        clearCategories();
+    }
+    
+    //Every object is categorized again
+    void ObjectTracker::clearCategories(){
+        for (int i = 0; i < objects.getSlotCount(); i++) {
+            if (objects.isAlive(i)) {
+                objects.getSlot(i).setCategory(0);
+            }
+        }
+    }
+    
+    void ObjectTracker::setCategorySampling(int minSamples, int maxSamples){
+        categorizer.setSampling(minSamples, maxSamples);
+    }
+    
+    const ObjectDescriptor* ObjectTracker::getObjectDescriptor(unsigned int label){
+        return categorizer.getDescriptor(label);
+    }
+    
+    //--------------------------------------------------------------
+    bool ObjectTracker::startRecording(string path, int s){
+        return sensors[s]->recorder.start(path, *sensors[s]->source);
+    }
+    
+    void ObjectTracker::stopRecording(int s){
+        sensors[s]->recorder.stop();
+    }
+    
+    bool ObjectTracker::isRecording(int s){
+        return sensors[s]->recorder.isRecording();
+    }
+    
+    //--------------------------------------------------------------
+    bool ObjectTracker::startPublishing(string name, int maxObjects, int maxHands){
+        return publisher.setup(name, maxObjects, maxHands);
+    }
+    
+    void ObjectTracker::stopPublishing(){
+        publisher.close();
+    }
+    
+    bool ObjectTracker::isPublishing(){
+        return publisher.isOpen();
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::startBgCalibration(int s){
+        Sensor& sensor = *sensors[s];
+        sensor.bCalibratingBackground = !sensor.bCalibratingBackground;
+        if (sensor.bCalibratingBackground){
+            sensor.backgroundPoints.clear();
+        }
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::startAutoBgCalibration(int frames, int s){
+        Sensor& sensor = *sensors[s];
+        sensor.backgroundModel.reset();
+        sensor.autoCalibrationFrames = frames;
+        sensor.bAutoCalibratingBackground = true;
+    }
+    
+    bool ObjectTracker::isAutoBgCalibrating(){
+        for (int s = 0; s < sensors.size(); s++) {
+            if (sensors[s]->bAutoCalibratingBackground) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    //--------------------------------------------------------------
+    void ObjectTracker::applyBackgroundModel(Sensor& sensor){
+        ofLogNotice("ObjectTracker") << "background model: " << sensor.backgroundModel.getFrameCount() << " frames, "
+        << int(sensor.backgroundModel.getValidRatio() * 100) << "% valid pixels";
+        
+        // the worker may still be using the current segmenter
+        shared_ptr<DepthSegmenter> calibrated(new DepthSegmenter(*sensor.segmenter));
+        calibrated->setBackgroundDepth(sensor.backgroundModel.getBackgroundDepth());
+        sensor.segmenter = calibrated;
+    }
+    
+    void ObjectTracker::applyBackgroundPlane(Sensor& sensor, ofVec3f v0, ofVec3f n){
+        sensor.background_v0 = v0;
+        sensor.background_n = n;
+        
+        // the worker may still be using the current segmenter
+        shared_ptr<DepthSegmenter> calibrated(new DepthSegmenter(*sensor.segmenter));
+        if (!calibrated->hasRays()) {
+            calibrated->setRays(*sensor.source);
+        }
+        calibrated->setBackgroundPlane(v0, n);
+        sensor.segmenter = calibrated;
+    }
+    
+    //--------------------------------------------------------------
+    static PlaneFit fitPlane(PlaneFitter fitter, const vector<unsigned short>* depth, shared_ptr<const DepthSegmenter> segmenter){
+        return fitter.fit(&(*depth)[0], *segmenter);
+    }
+    
+    static float verifyPlane(PlaneFitter fitter, const vector<unsigned short>* depth, shared_ptr<const DepthSegmenter> segmenter, PlaneFit plane){
+        return fitter.verify(&(*depth)[0], *segmenter, plane);
+    }
+    
+    static bool isReady(const std::future<PlaneFit>& future){
+        return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    
+    static bool isReady(const std::future<float>& future){
+        return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    
+    // Plane fits and checks run on a copy of the frame, one at a time per
+    // sensor, and are picked up by a later update()
+    void ObjectTracker::updatePlane(Sensor& sensor, const unsigned short* depth){
+        float now = ofGetElapsedTimef();
+        if (isReady(sensor.planeFit)) {
+            PlaneFit fit = sensor.planeFit.get();
+            if (fit.bValid) {
+                ofLogNotice("ObjectTracker") << "plane fit: " << int(fit.inlierRatio * 100) << "% inliers, " << fit.rmsError << " mm rms";
+                sensor.plane = fit;
+                sensor.planeCheckRatio = fit.inlierRatio;
+                applyBackgroundPlane(sensor, fit.v0, fit.n);
+            }
+            sensor.lastPlaneCheck = now;
+        }
+        if (isReady(sensor.planeCheck)) {
+            sensor.planeCheckRatio = sensor.planeCheck.get();
+            if (sensor.planeCheckRatio < minPlaneInlierRatio_) {
+                ofLogWarning("ObjectTracker") << "plane check: " << int(sensor.planeCheckRatio * 100) << "% inliers, was "
+                << int(sensor.plane.inlierRatio * 100) << "%. Sensor moved?" << (bPlaneRefit_ ? " Fitting it again" : "");
+                if (bPlaneRefit_) {
+                    sensor.bAutoCalibratingPlane = true;
+                    sensor.planeFitTime = now;
+                }
+            }
+        }
+        if (sensor.planeFit.valid() || sensor.planeCheck.valid()) {
+            return;
+        }
+        
+        bool bFit = sensor.bAutoCalibratingPlane && now >= sensor.planeFitTime;
+        bool bCheck = planeCheckInterval_ > 0 && sensor.plane.bValid && now - sensor.lastPlaneCheck >= planeCheckInterval_;
+        if (!bFit && !bCheck) {
+            return;
+        }
+        if (!sensor.segmenter->hasRays()) {
+            return;
+        }
+        sensor.planeDepth.assign(depth, depth + sensor.source->getWidth() * sensor.source->getHeight());
+        if (bFit) {
+            sensor.bAutoCalibratingPlane = false;
+            sensor.planeFit = std::async(std::launch::async, fitPlane, planeFitter, &sensor.planeDepth, sensor.segmenter);
         } else {
-            objects[_label]->setCategory(2);
+            sensor.lastPlaneCheck = now;
+            sensor.planeCheck = std::async(std::launch::async, verifyPlane, planeFitter, &sensor.planeDepth, sensor.segmenter, sensor.plane);
+        }
+    }
+    
+    void ObjectTracker::startAutoPlaneCalibration(int s){
+        sensors[s]->bAutoCalibratingPlane = true;
+        sensors[s]->planeFitTime = ofGetElapsedTimef();
+    }
+    
+    bool ObjectTracker::isAutoPlaneCalibrating(){
+        for (int s = 0; s < sensors.size(); s++) {
+            if (sensors[s]->bAutoCalibratingPlane || sensors[s]->planeFit.valid()) {
+                return true;
+            }
         }
+        return false;
+    }
+    
+    float ObjectTracker::getPlaneInlierRatio(int s){
+        return sensors[s]->planeCheckRatio;
+    }
+    
+    void ObjectTracker::setPlaneVerification(float interval, float minInlierRatio, bool refit){
+        planeCheckInterval_ = MAX(interval, 0.f);
+        minPlaneInlierRatio_ = ofClamp(minInlierRatio, 0, 1);
+        bPlaneRefit_ = refit;
     }
     
     //--------------------------------------------------------------
-    void ObjectTracker::startBgCalibration(){        
-        bCalibratingBackground = !bCalibratingBackground;
-        if (bCalibratingBackground){
-            backgroundPoints.clear();
+    bool ObjectTracker::saveBackground(string path, int s){
+        return sensors[s]->backgroundModel.save(path);
+    }
+    
+    bool ObjectTracker::loadBackground(string path, int s){
+        //The model is set up at the sensor's size, so a file of another size doesn't load
+        Sensor& sensor = *sensors[s];
+        if (!sensor.backgroundModel.load(path)) {
+            return false;
         }
+        applyBackgroundModel(sensor);
+        return true;
     }
     
     //--------------------------------------------------------------
     bool ObjectTracker::mousePressed(ofMouseEventArgs &mouse){
-        if (bCalibratingBackground) {
-            if (backgroundPoints.size() < 3) {
-                int kinectMouseX = ofMap(ofGetMouseX(), kinectX, kinectX+kinectW, 0, kinect.getWidth());
-                int kinectMouseY = ofMap(ofGetMouseY(), kinectY, kinectY+kinectH, 0, kinect.getHeight());
-                backgroundPoints.push_back(kinect.getWorldCoordinateAt(kinectMouseX, kinectMouseY));
-            }
-            if (backgroundPoints.size() == 3){
-                bCalibratingBackground = false;
-                background_v0 = backgroundPoints[0];
-                background_n = (backgroundPoints[1]-backgroundPoints[0]).getCrossed(backgroundPoints[2]-backgroundPoints[0]).limit(1.0);
+        for (int s = 0; s < sensors.size(); s++) {
+            Sensor& sensor = *sensors[s];
+            DepthSource& source = *sensor.source;
+            //with several sensors, clicks go to the one drawn under the mouse
+            bool inside = ofRectangle(sensor.drawX, sensor.drawY, sensor.drawW, sensor.drawH).inside(ofGetMouseX(), ofGetMouseY());
+            if (!sensor.bCalibratingBackground || (sensors.size() > 1 && !inside)) {
+                continue;
+            }
+            if (sensor.backgroundPoints.size() < 3) {
+                int kinectMouseX = ofMap(ofGetMouseX(), sensor.drawX, sensor.drawX+sensor.drawW, 0, source.getWidth());
+                int kinectMouseY = ofMap(ofGetMouseY(), sensor.drawY, sensor.drawY+sensor.drawH, 0, source.getHeight());
+                sensor.backgroundPoints.push_back(source.getWorldCoordinateAt(kinectMouseX, kinectMouseY));
+            }
+            if (sensor.backgroundPoints.size() == 3){
+                sensor.bCalibratingBackground = false;
+                sensor.background_v0 = sensor.backgroundPoints[0];
+                sensor.background_n = (sensor.backgroundPoints[1]-sensor.backgroundPoints[0]).getCrossed(sensor.backgroundPoints[2]-sensor.backgroundPoints[0]).getNormalized();
+                applyBackgroundPlane(sensor, sensor.background_v0, sensor.background_n);
             }
         }
     }
@@ -9,9 +9,23 @@
 #ifndef __ofxKinectObjects__
 #define __ofxKinectObjects__
 
+#include <future>
 #include "ofxKinect.h"
 #include "ofxCv.h"
 #include "ofxKinectObjectsEvents.h"
+#include "ofxKinectObjectsSegmenter.h"
+#include "ofxKinectObjectsPipeline.h"
+#include "ofxKinectObjectsTouchIndex.h"
+#include "ofxKinectObjectsSlotMap.h"
+#include "ofxKinectObjectsSnapshot.h"
+#include "ofxKinectObjectsBackgroundModel.h"
+#include "ofxKinectObjectsFusion.h"
+#include "ofxKinectObjectsReplay.h"
+#include "ofxKinectObjectsSyntheticSource.h"
+#include "ofxKinectObjectsPublisher.h"
+#include "ofxKinectObjectsTouchPredictor.h"
+#include "ofxKinectObjectsCategorizer.h"
+#include "ofxKinectObjectsPlaneFitter.h"
 
 
 namespace ofxKinectObjects {
@@ -28,10 +42,11 @@ namespace ofxKinectObjects {
         unsigned int category_, touchedBy_;
         bool updated_;
     public:
-        FloorObject(){};
+        FloorObject();
         FloorObject(float area, ofVec3f worldCoordinates, vector<ofVec3f> quad);
         
-        //Hand events handlers
+        //Hand events handlers. ObjectTracker resolves touches itself and does
+        //not register objects on these events.
         void handOn(HandOnEvent &e);
         void handOut(HandOutEvent &e);
         
@@ -48,55 +63,222 @@ namespace ofxKinectObjects {
         
         void touch (unsigned int handLabel);
         bool isTouched ();
+        unsigned int getTouchedBy();
+    };
+
+    // One depth source and everything that is tracked from it alone: its
+    // own background calibration, segmenter and detection pipeline.
+    struct Sensor{
+        Sensor();
+        shared_ptr<DepthSource> source;
+        DepthRecorder recorder;
+        //source world coordinates to table coordinates
+        ofMatrix4x4 toTable;
+        
+        //Detection & CV images
+        DetectionPipeline pipeline;
+        PipelineThread pipelineThread;
+        TripleBuffer<DepthFrame> depthFrames;
+        TripleBuffer<TrackingFrame> trackingFrames;
+        unsigned long long frameNumber;
+        //frameNumber of the last tracking result
+        unsigned long long trackedFrameNumber;
+        ofImage objectsImage;
+        ofImage handsImage;
+        bool bObjectsImageDirty, bHandsImageDirty;
+        TouchIndex touchIndex;
+        //Where drawInput() last drew it
+        int drawX, drawY, drawW, drawH;
+        
+        //Background
+        bool bCalibratingBackground;
+        vector<ofVec3f> backgroundPoints;
+        ofVec3f background_n;
+        ofVec3f background_v0;
+        BackgroundModel backgroundModel;
+        bool bAutoCalibratingBackground;
+        int autoCalibrationFrames;
+        shared_ptr<DepthSegmenter> segmenter;
+        
+        //Automatic plane fit and its checks, on background threads
+        bool bAutoCalibratingPlane;
+        //Not before this time (ofGetElapsedTimef())
+        float planeFitTime;
+        float lastPlaneCheck;
+        PlaneFit plane;
+        float planeCheckRatio;
+        vector<unsigned short> planeDepth;
+        std::future<PlaneFit> planeFit;
+        std::future<float> planeCheck;
     };
 
     class ObjectTracker{
     public:
         ObjectTracker();
-        void setup();
+        //Run segmentation and contour finding on a worker thread. Call before setup().
+        void setPipelined(bool pipelined);
+        bool isPipelined();
+        //Besides FrameTrackedEvent, send HandOnEvent, HandOutEvent and TouchEvent one by one (default)
+        void setPerHandEvents(bool perHandEvents);
+        bool getPerHandEvents();
+        //Keep the detector masks CPU-only and never build images from them
+        void setHeadless(bool headless);
+        bool isHeadless();
+        //Opens kinects 0..numSensors-1. More than one sensor is always pipelined,
+        //with a worker thread per sensor.
+        void setup(int numSensors = 1);
+        //Track recordings (ReplaySource) or other sources instead of kinects
+        void setup(vector<shared_ptr<DepthSource> > sources);
         void update();
         void updateParameters(ofVec2f floorThreshold, ofVec2f handsThreshold, ofVec2f objectsBlobSize, ofVec2f handsBlobSize, bool drawDetectors);
-        void drawObjectDetector(int x, int y, int w, int h);
-        void drawHandsDetector(int x, int y, int w, int h);
-        void drawInput(int x, int y, int w, int h);
+        //Resolution of each detector: 1 (full), 2 (half) or 4 (quarter). Blob
+        //sizes and everything the tracker reports stay in full resolution pixels.
+        void setDecimation(int objectsDecimation, int handsDecimation);
+        //Find objects at least every interval frames, and sooner if more than
+        //changeArea pixels of the objects mask changed (0, only every interval)
+        void setObjectsSchedule(int interval, float changeArea = 0);
+        //Microseconds the detection of a frame may take (0, no budget). Object
+        //refreshes are put off to stay within it, a few frames at most; hands never are.
+        void setFrameBudget(float micros);
+        //Segment only the tiles (tileSize pixels a side) whose depth changed by
+        //more than changeThreshold mm, and find contours only in masks that
+        //changed, over the whole mask. 0, the whole frame every time (default).
+        void setIncrementalSegmentation(int tileSize, float changeThreshold = 10);
+        //Label the blobs while segmenting instead of tracing their contours.
+        //Faster, gives blob heights, but contours are just the quads.
+        void setSinglePassLabeling(bool singlePassLabeling);
+        //Send TouchPredictedEvent for hands that will be on an object in
+        //lookAhead ms if they keep moving as they do (0, off). A prediction is
+        //raised after onFrames frames in a row and withdrawn after offFrames.
+        void setTouchPrediction(float lookAhead, int onFrames = 2, int offFrames = 3);
+        int getNumSensors();
+        //Where the sensor is on the table: maps its world coordinates to table coordinates
+        void setSensorTransform(int sensor, ofMatrix4x4 toTable);
+        //Table distance (mm) under which blobs of different sensors are the same one
+        void setMergeDistance(float distance);
+        void drawObjectDetector(int x, int y, int w, int h, int sensor = 0);
+        void drawHandsDetector(int x, int y, int w, int h, int sensor = 0);
+        void drawInput(int x, int y, int w, int h, int sensor = 0);
         void setKinectAngle(int angle);
-        void startBgCalibration();
+        //Record the sensor's depth frames for ReplaySource
+        bool startRecording(string path, int sensor = 0);
+        void stopRecording(int sensor = 0);
+        bool isRecording(int sensor = 0);
+        //Write every result to shared memory, for SharedResultsReader in other processes
+        bool startPublishing(string name = sharedResultsDefaultName, int maxObjects = 64, int maxHands = 16);
+        void stopPublishing();
+        bool isPublishing();
+        //Click three points of the surface on the sensor's drawInput()
+        void startBgCalibration(int sensor = 0);
+        //Learn the background depth of every pixel from the next frames
+        void startAutoBgCalibration(int frames = 60, int sensor = 0);
+        bool isAutoBgCalibrating();
+        bool saveBackground(string path, int sensor = 0);
+        bool loadBackground(string path, int sensor = 0);
+        //Fit the table plane from the next frame, without clicks. The fit and
+        //its inlier ratio are logged, and the plane applied if there is one.
+        void startAutoPlaneCalibration(int sensor = 0);
+        bool isAutoPlaneCalibrating();
+        //Of the last fit or check of the sensor, 0 to 1
+        float getPlaneInlierRatio(int sensor = 0);
+        //Every interval seconds (0, never), check on a background thread that the
+        //fitted plane still holds minInlierRatio of the pixels, and fit it again
+        //if it doesn't and refit is set: the sensor was bumped or tilted
+        void setPlaneVerification(float interval, float minInlierRatio = 0.5, bool refit = true);
+        //All sensors are calibrated
         bool isBgCalibrated();
+        //Category table (see Categorizer::load()). Without one, objects are
+        //category 1 or 2 by size.
+        bool loadCategories(string path);
+        void setCategories(const vector<ObjectCategory>& categories);
+        //Frames an object is measured before its category may freeze, and at most
+        void setCategorySampling(int minSamples, int maxSamples);
+        //What the categorizer measured of an object, NULL if nothing
+        const ObjectDescriptor* getObjectDescriptor(unsigned int label);
+        //Objects and hands of the latest tracking result
+        const FrameSnapshot& getSnapshot() const;
+    #ifdef OFX_KINECT_OBJECTS_STATS
+        const TrackerStats& getStats() const;
+        void resetStats();
+        //Draw the stats next to drawInput() of sensor 0
+        void setDrawStats(bool drawStats);
+        void drawStats(int x, int y);
+        //Append stage percentiles and counters to a CSV file every interval seconds
+        void setStatsDump(string path, float interval = 1);
+    #endif
         void exit();
         
     private:
         bool mousePressed(ofMouseEventArgs& mouse);
-        float distanceToBackground (int kinectX, int kinectY);
+        float distanceToBackground (Sensor& sensor, int kinectX, int kinectY);
         void selectCategory (unsigned int _label);
+        void categorize(const TrackedBlob& blob, unsigned long long frameNumber);
+        void clearCategories();
+        void applyBackgroundModel(Sensor& sensor);
+        void applyBackgroundPlane(Sensor& sensor, ofVec3f v0, ofVec3f n);
+        void updatePlane(Sensor& sensor, const unsigned short* depth);
+        void updateSensor(Sensor& sensor);
+        void updateTracking();
+        void updateObjects(const FusedFrame& frame);
+        void resolveTouches(const FusedFrame& frame);
+        void notifyTouch(unsigned int objectLabel, unsigned int handLabel, bool touched);
+        void predictTouches(const FusedFrame& frame);
         
-        //Kinect
-        ofxKinect kinect;
-        int kinectX, kinectY, kinectW, kinectH;
-    #ifdef USE_TWO_KINECTS
-        ofxKinect kinect2;
-    #endif
+        //Kinects
+        vector<shared_ptr<Sensor> > sensors;
+        bool bPipelined_;
+        bool bHeadless_;
+        bool bPerHandEvents_;
         
-        //CV images & contour finders
-        ofImage objectsImage;
-        ofImage handsImage;
-        ofxCv::ContourFinder objectsFinder;
-        ofxCv::ContourFinder handsFinder;
+        //Fusion of the latest result of every sensor
+        SensorFusion fusion;
+        FusedFrame fused;
+        vector<const TrackingFrame*> sensorFrames;
+        vector<bool> sensorFramesNew;
+        vector<ofMatrix4x4> sensorTransforms;
         
         //Parameters
         ofVec2f floorThreshold_;
         ofVec2f handsThreshold_;
         ofVec2f objectsBlobSize_;
         ofVec2f handsBlobSize_;
+        int objectsDecimation_;
+        int handsDecimation_;
+        int objectsInterval_;
+        float objectsChangeArea_;
+        float frameBudget_;
+        int tileSize_;
+        float changeThreshold_;
+        bool bSinglePassLabeling_;
+        PlaneFitter planeFitter;
+        float planeCheckInterval_;
+        float minPlaneInlierRatio_;
+        bool bPlaneRefit_;
         bool drawDetectors_;
         
-        //Objects
-        map<unsigned int, FloorObject*> objects;
+        //Stage times of the current update()
+        StageTimes frameTimes;
+    #ifdef OFX_KINECT_OBJECTS_STATS
+        TrackerStats stats;
+        bool bDrawStats_;
+    #endif
         
-        //Background
-        bool bCalibratingBackground;
-        vector<ofVec3f> backgroundPoints;
-        ofVec3f background_n;
-        ofVec3f background_v0;        
+        //Objects, by label
+        SlotMap<FloorObject> objects;
+        Categorizer categorizer;
+        FrameSnapshot snapshot;
+        //Row in the fused frame of each object label
+        unordered_map<unsigned int, int> objectRows;
+        vector<TouchEvent> touches;
+        TouchPredictor predictor;
+        vector<TouchPredictedEvent> predictions;
+        vector<pair<unsigned int, unsigned int> > predictedPairs;
+        vector<ofPoint> predictedQuad;
+        FrameTrackedEvent frameEvent;
+        ResultsPublisher publisher;
+        vector<int> touchHits;
+        vector<unsigned int> firstHands;
+        vector<bool> touchedByStillOn;
     };
     
     vector<ofPoint> ofxCvPointQuadToOfPointQuad (vector<cv::Point> cvPointQuad);
@@ -0,0 +1,167 @@
+//
+//  ofxKinectObjectsBackgroundModel.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsBackgroundModel.h"
+
+namespace ofxKinectObjects {
+
+    static const char modelMagic[4] = {'O', 'K', 'O', 'B'};
+    static const int modelVersion = 1;
+    //Larger sides are not a depth camera, but a corrupt header
+    static const int maxModelSide = 8192;
+
+    BackgroundModel::BackgroundModel(){
+        width_ = height_ = frames_ = 0;
+        maxStdDev_ = 20;
+    }
+
+    void BackgroundModel::setup(int width, int height){
+        width_ = width;
+        height_ = height;
+        reset();
+    }
+
+    void BackgroundModel::reset(){
+        frames_ = 0;
+        mean_.assign(width_ * height_, 0);
+        m2_.assign(width_ * height_, 0);
+        count_.assign(width_ * height_, 0);
+    }
+
+    //--------------------------------------------------------------
+    void BackgroundModel::addFrame(const unsigned short* depth){
+        for (int k = 0; k < mean_.size(); k++) {
+            if (depth[k] == 0 || count_[k] == USHRT_MAX) {
+                continue;
+            }
+            count_[k]++;
+            float delta = depth[k] - mean_[k];
+            mean_[k] += delta / count_[k];
+            m2_[k] += delta * (depth[k] - mean_[k]);
+        }
+        frames_++;
+    }
+
+    //--------------------------------------------------------------
+    int BackgroundModel::getWidth() const{
+        return width_;
+    }
+
+    int BackgroundModel::getHeight() const{
+        return height_;
+    }
+
+    int BackgroundModel::getFrameCount() const{
+        return frames_;
+    }
+
+    void BackgroundModel::setMaxStdDev(float maxStdDev){
+        maxStdDev_ = maxStdDev;
+    }
+
+    //--------------------------------------------------------------
+    bool BackgroundModel::isValid(int k) const{
+        return frames_ > 0 && count_[k] * 2 >= frames_ && m2_[k] <= maxStdDev_ * maxStdDev_ * count_[k];
+    }
+
+    bool BackgroundModel::isValid(int x, int y) const{
+        return isValid(y * width_ + x);
+    }
+
+    float BackgroundModel::getMean(int x, int y) const{
+        return mean_[y * width_ + x];
+    }
+
+    float BackgroundModel::getStdDev(int x, int y) const{
+        int k = y * width_ + x;
+        return count_[k] > 0 ? sqrtf(m2_[k] / count_[k]) : 0;
+    }
+
+    float BackgroundModel::getValidRatio() const{
+        if (mean_.empty()) {
+            return 0;
+        }
+        int valid = 0;
+        for (int k = 0; k < mean_.size(); k++) {
+            if (isValid(k)) {
+                valid++;
+            }
+        }
+        return valid / float(mean_.size());
+    }
+
+    //--------------------------------------------------------------
+    vector<float> BackgroundModel::getBackgroundDepth() const{
+        vector<float> depth(mean_.size(), 0);
+        for (int k = 0; k < mean_.size(); k++) {
+            if (isValid(k)) {
+                depth[k] = mean_[k];
+            }
+        }
+        return depth;
+    }
+
+    //--------------------------------------------------------------
+    bool BackgroundModel::save(string path) const{
+        if (mean_.empty()) {
+            ofLogError("BackgroundModel") << "save(): empty model";
+            return false;
+        }
+        ofstream file(ofToDataPath(path).c_str(), ios::binary);
+        if (!file) {
+            ofLogError("BackgroundModel") << "save(): couldn't open " << path;
+            return false;
+        }
+        int header[4] = {modelVersion, width_, height_, frames_};
+        file.write(modelMagic, sizeof(modelMagic));
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)&mean_[0], mean_.size() * sizeof(float));
+        file.write((const char*)&m2_[0], m2_.size() * sizeof(float));
+        file.write((const char*)&count_[0], count_.size() * sizeof(unsigned short));
+        return file.good();
+    }
+
+    bool BackgroundModel::load(string path){
+        ifstream file(ofToDataPath(path).c_str(), ios::binary);
+        char magic[4];
+        int header[4];
+        if (!file.read(magic, sizeof(magic)) || memcmp(magic, modelMagic, sizeof(magic)) != 0
+            || !file.read((char*)header, sizeof(header)) || header[0] != modelVersion) {
+            ofLogError("BackgroundModel") << "load(): " << path << " is not a background model";
+            return false;
+        }
+        int width = header[1], height = header[2];
+        if (width <= 0 || height <= 0 || width > maxModelSide || height > maxModelSide) {
+            ofLogError("BackgroundModel") << "load(): " << path << " has size " << width << "x" << height;
+            return false;
+        }
+        if (width_ > 0 && (width != width_ || height != height_)) {
+            ofLogError("BackgroundModel") << "load(): " << path << " is " << width << "x" << height << ", not " << width_ << "x" << height_;
+            return false;
+        }
+
+        //Into new buffers: the current model stays if the file is truncated
+        vector<float> mean(width * height), m2(width * height);
+        vector<unsigned short> count(width * height);
+        file.read((char*)&mean[0], mean.size() * sizeof(float));
+        file.read((char*)&m2[0], m2.size() * sizeof(float));
+        file.read((char*)&count[0], count.size() * sizeof(unsigned short));
+        if (!file) {
+            ofLogError("BackgroundModel") << "load(): " << path << " is truncated";
+            return false;
+        }
+        width_ = width;
+        height_ = height;
+        frames_ = header[3];
+        mean_.swap(mean);
+        m2_.swap(m2);
+        count_.swap(count);
+        return true;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,55 @@
+//
+//  ofxKinectObjectsBackgroundModel.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+namespace ofxKinectObjects {
+
+    // Per-pixel background depth learned from a few frames of the empty
+    // surface. Keeps a running mean and variance per pixel (Welford), skipping
+    // the 0s the kinect reports where it has no depth. A pixel is valid if it
+    // got depth in at least half the frames and is not too noisy.
+    class BackgroundModel{
+    public:
+        BackgroundModel();
+        void setup(int width, int height);
+        void reset();
+        void addFrame(const unsigned short* depth);
+
+        int getWidth() const;
+        int getHeight() const;
+        int getFrameCount() const;
+
+        //Pixels with a larger standard deviation (mm) are left out of the model
+        void setMaxStdDev(float maxStdDev);
+
+        bool isValid(int x, int y) const;
+        float getMean(int x, int y) const;
+        float getStdDev(int x, int y) const;
+        float getValidRatio() const;
+
+        //Mean depth (mm) of valid pixels, 0 elsewhere
+        vector<float> getBackgroundDepth() const;
+
+        //Binary file: header followed by mean, variance and sample count per pixel.
+        //After setup(), only files of that size load. A failed load keeps the model.
+        bool save(string path) const;
+        bool load(string path);
+
+    private:
+        bool isValid(int k) const;
+
+        int width_, height_, frames_;
+        float maxStdDev_;
+        vector<float> mean_;
+        vector<float> m2_;
+        vector<unsigned short> count_;
+    };
+
+} //namespace ofxKinectObjects
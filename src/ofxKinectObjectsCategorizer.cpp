@@ -0,0 +1,228 @@
+//
+//  ofxKinectObjectsCategorizer.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsCategorizer.h"
+#include "ofxKinectObjectsTouchIndex.h"
+
+namespace ofxKinectObjects {
+
+    //Relative error of the mean area and height under which descriptors are steady
+    static const float steadyError = 0.03;
+
+    RunningStat::RunningStat(){
+        count = 0;
+        mean = m2 = 0;
+    }
+
+    void RunningStat::add(float value){
+        count++;
+        float delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    float RunningStat::getVariance() const{
+        return count > 1 ? m2 / (count - 1) : 0;
+    }
+
+    float RunningStat::getRelativeError() const{
+        if (count < 2 || mean == 0) {
+            return FLT_MAX;
+        }
+        return sqrt(getVariance() / count) / fabs(mean);
+    }
+
+    ObjectSample::ObjectSample(){
+        area = height = volume = aspect = 0;
+    }
+
+    ObjectDescriptor::ObjectDescriptor(){
+        lastFrame = 0;
+        category = 0;
+        bFrozen = false;
+    }
+
+    void ObjectDescriptor::add(const ObjectSample& sample){
+        area.add(sample.area);
+        height.add(sample.height);
+        volume.add(sample.volume);
+        aspect.add(sample.aspect);
+    }
+
+    ObjectCategory::ObjectCategory(){
+        id = 0;
+        area = height = volume = aspect = 0;
+        tolerance = 0.25;
+    }
+
+    /***
+     CATEGORIZER
+     **___________________________________*/
+
+    Categorizer::Categorizer(){
+        minSamples_ = 15;
+        maxSamples_ = 90;
+    }
+
+    bool Categorizer::load(string path){
+        ifstream file(ofToDataPath(path).c_str());
+        if (!file) {
+            ofLogError("Categorizer") << "load(): couldn't open " << path;
+            return false;
+        }
+        vector<ObjectCategory> categories;
+        string line;
+        for (int lineNumber = 1; getline(file, line); lineNumber++) {
+            istringstream fields(line);
+            string first;
+            if (!(fields >> first) || first[0] == '#') {
+                continue;
+            }
+            fields.clear();
+            fields.seekg(0);
+            ObjectCategory category;
+            if (!(fields >> category.id >> category.name >> category.area >> category.height >> category.volume >> category.aspect >> category.tolerance) || category.id == 0 || category.tolerance <= 0) {
+                ofLogError("Categorizer") << "load(): " << path << ":" << lineNumber << " is not a category";
+                return false;
+            }
+            categories.push_back(category);
+        }
+        setCategories(categories);
+        return true;
+    }
+
+    //Objects sampled so far start again with the new table
+    void Categorizer::setCategories(const vector<ObjectCategory>& categories){
+        categories_ = categories;
+        descriptors.clear();
+    }
+
+    const vector<ObjectCategory>& Categorizer::getCategories() const{
+        return categories_;
+    }
+
+    bool Categorizer::hasCategories() const{
+        return !categories_.empty();
+    }
+
+    void Categorizer::setSampling(int minSamples, int maxSamples){
+        minSamples_ = MAX(minSamples, 2);
+        maxSamples_ = MAX(maxSamples, minSamples_);
+    }
+
+    //--------------------------------------------------------------
+    bool Categorizer::measure(const unsigned short* depth, const DepthSegmenter& segmenter, const vector<ofPoint>& quad, const vector<ofVec3f>& worldQuad, float minHeight, float pixelSize, ObjectSample& sample){
+        int width = segmenter.getWidth(), height = segmenter.getHeight();
+        float x0 = width, y0 = height, x1 = 0, y1 = 0;
+        for (int k = 0; k < quad.size(); k++) {
+            x0 = MIN(x0, quad[k].x);
+            y0 = MIN(y0, quad[k].y);
+            x1 = MAX(x1, quad[k].x);
+            y1 = MAX(y1, quad[k].y);
+        }
+
+        sample = ObjectSample();
+        int pixels = 0;
+        for (int j = MAX(int(y0), 0); j <= MIN(int(y1), height - 1); j++) {
+            for (int i = MAX(int(x0), 0); i <= MIN(int(x1), width - 1); i++) {
+                unsigned short z = depth[j * width + i];
+                if (z == 0 || !quadContains(quad, i, j)) {
+                    continue;
+                }
+                float distance = segmenter.getDistanceToBackground(z, i, j);
+                if (distance < minHeight) {
+                    continue;
+                }
+                //The pixel spans z * pixelSize mm a side at its depth
+                float area = z * pixelSize * z * pixelSize;
+                sample.area += area;
+                sample.volume += area * distance;
+                sample.height = MAX(sample.height, distance);
+                pixels++;
+            }
+        }
+        if (pixels == 0 || worldQuad.size() < 3) {
+            return false;
+        }
+        float a = worldQuad[0].distance(worldQuad[1]), b = worldQuad[1].distance(worldQuad[2]);
+        sample.aspect = MAX(a, b) > 0 ? MIN(a, b) / MAX(a, b) : 0;
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    bool Categorizer::needsSample(unsigned int label, unsigned long long frameNumber){
+        ObjectDescriptor* descriptor = descriptors.find(label);
+        return !descriptor || (!descriptor->bFrozen && descriptor->lastFrame != frameNumber);
+    }
+
+    unsigned int Categorizer::addSample(unsigned int label, unsigned long long frameNumber, const ObjectSample& sample){
+        ObjectDescriptor* descriptor = descriptors.find(label);
+        if (!descriptor) {
+            descriptor = &descriptors.insert(label, ObjectDescriptor());
+        }
+        if (descriptor->bFrozen) {
+            return descriptor->category;
+        }
+        descriptor->add(sample);
+        descriptor->lastFrame = frameNumber;
+
+        int samples = descriptor->area.count;
+        if (samples < minSamples_) {
+            return descriptor->category;
+        }
+        float distance;
+        int best = classify(*descriptor, distance);
+        descriptor->category = best >= 0 && distance <= 1 ? categories_[best].id : 0;
+
+        // a match on steady descriptors is final, and after maxSamples whatever there is
+        bool steady = descriptor->area.getRelativeError() < steadyError && descriptor->height.getRelativeError() < steadyError;
+        if ((descriptor->category != 0 && steady) || samples >= maxSamples_) {
+            descriptor->bFrozen = true;
+        }
+        return descriptor->category;
+    }
+
+    int Categorizer::classify(const ObjectDescriptor& descriptor, float& distance) const{
+        int best = -1;
+        distance = FLT_MAX;
+        for (int c = 0; c < categories_.size(); c++) {
+            const ObjectCategory& category = categories_[c];
+            float expected[4] = {category.area, category.height, category.volume, category.aspect};
+            float measured[4] = {descriptor.area.mean, descriptor.height.mean, descriptor.volume.mean, descriptor.aspect.mean};
+            float sum = 0;
+            int features = 0;
+            for (int f = 0; f < 4; f++) {
+                if (expected[f] == 0) {
+                    continue;
+                }
+                float error = (measured[f] - expected[f]) / (expected[f] * category.tolerance);
+                sum += error * error;
+                features++;
+            }
+            if (features > 0 && sqrt(sum / features) < distance) {
+                distance = sqrt(sum / features);
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    //--------------------------------------------------------------
+    const ObjectDescriptor* Categorizer::getDescriptor(unsigned int label){
+        return descriptors.find(label);
+    }
+
+    void Categorizer::erase(const vector<unsigned int>& labels){
+        descriptors.erase(labels);
+    }
+
+    void Categorizer::clear(){
+        descriptors.clear();
+    }
+
+} //namespace ofxKinectObjects
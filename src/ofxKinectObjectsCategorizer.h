@@ -0,0 +1,99 @@
+//
+//  ofxKinectObjectsCategorizer.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsSegmenter.h"
+#include "ofxKinectObjectsSlotMap.h"
+
+namespace ofxKinectObjects {
+
+    //Running mean and variance (Welford)
+    struct RunningStat{
+        RunningStat();
+        void add(float value);
+        float getVariance() const;
+        //Standard deviation of the mean, relative to it
+        float getRelativeError() const;
+        int count;
+        float mean;
+        float m2;
+    };
+
+    //What one frame shows of an object
+    struct ObjectSample{
+        ObjectSample();
+        //Top of the object (mm2)
+        float area;
+        //Highest and total over the background (mm, mm3)
+        float height;
+        float volume;
+        //Short side over long side of the world quad, 0 to 1
+        float aspect;
+    };
+
+    //Descriptors of an object accumulated over its frames
+    struct ObjectDescriptor{
+        ObjectDescriptor();
+        void add(const ObjectSample& sample);
+        RunningStat area, height, volume, aspect;
+        unsigned long long lastFrame;
+        unsigned int category;
+        //Category decided: nothing else is measured
+        bool bFrozen;
+    };
+
+    // A category of the table. A zero feature is not compared, and each
+    // compared feature may be off by tolerance (relative) from the object.
+    struct ObjectCategory{
+        ObjectCategory();
+        unsigned int id;
+        string name;
+        float area, height, volume, aspect;
+        float tolerance;
+    };
+
+    // Categorizes objects from their depth pixels. Each object gathers
+    // samples until its descriptors are steady and match a category of
+    // the table, or until maxSamples, and then its category freezes and
+    // the object costs nothing more. Unmatched objects freeze as 0.
+    class Categorizer{
+    public:
+        Categorizer();
+
+        // Text file, one category per line, # for comments:
+        // id name area(mm2) height(mm) volume(mm3) aspect tolerance
+        bool load(string path);
+        void setCategories(const vector<ObjectCategory>& categories);
+        const vector<ObjectCategory>& getCategories() const;
+        bool hasCategories() const;
+        //Samples before an object may freeze, and after which it always does
+        void setSampling(int minSamples, int maxSamples);
+
+        //Samples the pixels of the object inside quad (kinect pixels) above
+        //minHeight. pixelSize: mm a pixel spans per mm of depth.
+        static bool measure(const unsigned short* depth, const DepthSegmenter& segmenter, const vector<ofPoint>& quad, const vector<ofVec3f>& worldQuad, float minHeight, float pixelSize, ObjectSample& sample);
+
+        //Objects seen by several sensors are sampled once per frame
+        bool needsSample(unsigned int label, unsigned long long frameNumber);
+        //Category after adding the sample
+        unsigned int addSample(unsigned int label, unsigned long long frameNumber, const ObjectSample& sample);
+        //NULL for objects never sampled
+        const ObjectDescriptor* getDescriptor(unsigned int label);
+        void erase(const vector<unsigned int>& labels);
+        void clear();
+
+    private:
+        //Index of the closest category and its distance, 1 being the tolerance
+        int classify(const ObjectDescriptor& descriptor, float& distance) const;
+
+        vector<ObjectCategory> categories_;
+        int minSamples_, maxSamples_;
+        SlotMap<ObjectDescriptor> descriptors;
+    };
+
+} //namespace ofxKinectObjects
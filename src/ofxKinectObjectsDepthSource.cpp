@@ -0,0 +1,130 @@
+//
+//  ofxKinectObjectsDepthSource.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsDepthSource.h"
+
+namespace ofxKinectObjects {
+
+    ofVec3f DepthSource::getWorldCoordinateAt(int x, int y){
+        x = ofClamp(x, 0, getWidth() - 1);
+        y = ofClamp(y, 0, getHeight() - 1);
+        return getWorldCoordinateAt(float(x), float(y), float(getDepthPixels()[y * getWidth() + x]));
+    }
+
+    void DepthSource::drawDepthImage(ofImage& image, bool& bDirty, float x, float y, float w, float h){
+        if (getWidth() == 0 || getHeight() == 0) {
+            return;
+        }
+        if (bDirty || !image.isAllocated()) {
+            if (!image.isAllocated()) {
+                image.allocate(getWidth(), getHeight(), OF_IMAGE_GRAYSCALE);
+            }
+            const unsigned short* depth = getDepthPixels();
+            unsigned char* pixels = image.getPixelsRef().getPixels();
+            for (int i = 0; i < getWidth() * getHeight(); i++) {
+                pixels[i] = depth[i] == 0 ? 0 : ofMap(depth[i], 500, 4000, 255, 0, true);
+            }
+            image.update();
+            bDirty = false;
+        }
+        image.draw(x, y, w, h);
+    }
+
+    /***
+     KINECT
+     **___________________________________*/
+
+    KinectSource::KinectSource(int deviceId){
+        deviceId_ = deviceId;
+        timestamp_ = 0;
+    }
+
+    bool KinectSource::setup(){
+        // enable depth->video image calibration
+        kinect.setRegistration(true);
+
+        //kinect.init();
+        //kinect.init(true); // shows infrared instead of RGB video image
+        kinect.init(false, false); // disable video image (faster fps)
+
+        kinect.open(deviceId_);
+        //kinect.open("A00362A08602047A");	// open a kinect using it's unique serial #
+
+        // print the intrinsic IR sensor values
+        if(kinect.isConnected()) {
+            ofLogNotice() << "kinect " << deviceId_ << " sensor-emitter dist: " << kinect.getSensorEmitterDistance() << "cm";
+            ofLogNotice() << "kinect " << deviceId_ << " sensor-camera dist:  " << kinect.getSensorCameraDistance() << "cm";
+            ofLogNotice() << "kinect " << deviceId_ << " zero plane pixel size: " << kinect.getZeroPlanePixelSize() << "mm";
+            ofLogNotice() << "kinect " << deviceId_ << " zero plane dist: " << kinect.getZeroPlaneDistance() << "mm";
+        }
+
+        // zero the tilt on startup
+        kinect.setCameraTiltAngle(0);
+
+        return kinect.isConnected();
+    }
+
+    void KinectSource::update(){
+        kinect.update();
+        if (kinect.isFrameNew()) {
+            timestamp_ = ofGetElapsedTimef();
+        }
+    }
+
+    bool KinectSource::isFrameNew(){
+        return kinect.isFrameNew();
+    }
+
+    const unsigned short* KinectSource::getDepthPixels(){
+        return kinect.getRawDepthPixelsRef().getPixels();
+    }
+
+    int KinectSource::getWidth(){
+        return kinect.width;
+    }
+
+    int KinectSource::getHeight(){
+        return kinect.height;
+    }
+
+    double KinectSource::getTimestamp(){
+        return timestamp_;
+    }
+
+    ofVec3f KinectSource::getWorldCoordinateAt(float x, float y, float z){
+        return kinect.getWorldCoordinateAt(x, y, z);
+    }
+
+    float KinectSource::getZeroPlanePixelSize(){
+        return kinect.getZeroPlanePixelSize();
+    }
+
+    float KinectSource::getZeroPlaneDistance(){
+        return kinect.getZeroPlaneDistance();
+    }
+
+    void KinectSource::drawDepth(float x, float y, float w, float h){
+        kinect.drawDepth(x, y, w, h);
+    }
+
+    void KinectSource::setTiltAngle(float angle){
+        if(kinect.hasCamTiltControl()) {
+            kinect.setCameraTiltAngle(angle);
+        }
+    }
+
+    void KinectSource::close(){
+        kinect.setCameraTiltAngle(0); // zero the tilt on exit
+        kinect.close();
+    }
+
+    ofxKinect& KinectSource::getKinect(){
+        return kinect;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,76 @@
+//
+//  ofxKinectObjectsDepthSource.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinect.h"
+
+namespace ofxKinectObjects {
+
+    // Where ObjectTracker gets depth frames from: a kinect, or a recording
+    // (ReplaySource). Depth is in mm, 0 where unknown.
+    class DepthSource{
+    public:
+        virtual ~DepthSource() {}
+
+        virtual bool setup() = 0;
+        virtual void update() = 0;
+        virtual bool isFrameNew() = 0;
+        virtual const unsigned short* getDepthPixels() = 0;
+        virtual int getWidth() = 0;
+        virtual int getHeight() = 0;
+        //Seconds, time the current frame was captured
+        virtual double getTimestamp() = 0;
+
+        //World coordinates (mm) of pixel (x, y) at depth z, as ofxKinect::getWorldCoordinateAt()
+        virtual ofVec3f getWorldCoordinateAt(float x, float y, float z) = 0;
+        //Used by recordings to rebuild getWorldCoordinateAt()
+        virtual float getZeroPlanePixelSize() = 0;
+        virtual float getZeroPlaneDistance() = 0;
+
+        virtual void drawDepth(float x, float y, float w, float h) = 0;
+        //Sources without a motor ignore it
+        virtual void setTiltAngle(float angle) {}
+        virtual void close() = 0;
+
+        //At the depth of the current frame
+        ofVec3f getWorldCoordinateAt(int x, int y);
+
+    protected:
+        //As ofxKinect::drawDepth(): near (500mm) white to far (4000mm) black
+        void drawDepthImage(ofImage& image, bool& bDirty, float x, float y, float w, float h);
+    };
+
+    class KinectSource : public DepthSource{
+    public:
+        //Kinect by id, starting with 0 (sorted by serial # lexicographically)
+        KinectSource(int deviceId = 0);
+        using DepthSource::getWorldCoordinateAt;
+
+        bool setup();
+        void update();
+        bool isFrameNew();
+        const unsigned short* getDepthPixels();
+        int getWidth();
+        int getHeight();
+        double getTimestamp();
+        ofVec3f getWorldCoordinateAt(float x, float y, float z);
+        float getZeroPlanePixelSize();
+        float getZeroPlaneDistance();
+        void drawDepth(float x, float y, float w, float h);
+        void setTiltAngle(float angle);
+        void close();
+
+        ofxKinect& getKinect();
+
+    private:
+        ofxKinect kinect;
+        int deviceId_;
+        double timestamp_;
+    };
+
+} //namespace ofxKinectObjects
@@ -9,4 +9,7 @@
 #include "ofxKinectObjectsEvents.h"
 
 ofEvent<HandOnEvent> HandOnEvent::events;
-ofEvent<HandOutEvent> HandOutEvent::events;
\ No newline at end of file
+ofEvent<HandOutEvent> HandOutEvent::events;
+ofEvent<TouchEvent> TouchEvent::events;
+ofEvent<TouchPredictedEvent> TouchPredictedEvent::events;
+ofEvent<FrameTrackedEvent> FrameTrackedEvent::events;
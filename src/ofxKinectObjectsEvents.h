@@ -1,5 +1,6 @@
 #pragma once
 #include "ofMain.h"
+#include "ofxKinectObjectsSnapshot.h"
 
 class HandOnEvent : public ofEventArgs {
     
@@ -28,3 +29,68 @@ public:
     static ofEvent <HandOutEvent> events;
 };
 
+//An object started or stopped being touched by a hand
+class TouchEvent : public ofEventArgs {
+    
+public:
+    
+    unsigned int objectLabel;
+    unsigned int handLabel;
+    bool touched;
+    
+    TouchEvent() {
+        objectLabel = 0;
+        handLabel = 0;
+        touched = false;
+    }
+    
+    static ofEvent <TouchEvent> events;
+};
+
+//A hand is about to touch an object (predicted), or no longer looks like it
+//will and hasn't (not predicted). A TouchEvent follows if it does touch.
+class TouchPredictedEvent : public ofEventArgs {
+    
+public:
+    
+    unsigned int objectLabel;
+    unsigned int handLabel;
+    bool predicted;
+    
+    TouchPredictedEvent() {
+        objectLabel = 0;
+        handLabel = 0;
+        predicted = false;
+    }
+    
+    static ofEvent <TouchPredictedEvent> events;
+};
+
+//Everything one tracking result changed, in a single notification. The
+//vectors belong to ObjectTracker and are valid until its next update().
+class FrameTrackedEvent : public ofEventArgs {
+    
+public:
+    
+    unsigned long long frameNumber;
+    const vector<ofxKinectObjects::ObjectState>* objects;
+    const vector<ofxKinectObjects::HandState>* hands;
+    //Touches that began or ended, in order
+    const vector<TouchEvent>* touches;
+    //Touch predictions raised or withdrawn, with touch prediction on
+    const vector<TouchPredictedEvent>* predictions;
+    const vector<unsigned int>* deadObjectLabels;
+    const vector<unsigned int>* deadHandLabels;
+    
+    FrameTrackedEvent() {
+        frameNumber = 0;
+        objects = NULL;
+        hands = NULL;
+        touches = NULL;
+        predictions = NULL;
+        deadObjectLabels = NULL;
+        deadHandLabels = NULL;
+    }
+    
+    static ofEvent <FrameTrackedEvent> events;
+};
@@ -0,0 +1,158 @@
+//
+//  ofxKinectObjectsFusion.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsFusion.h"
+
+namespace ofxKinectObjects {
+
+    SensorFusion::Labels::Labels(){
+        nextLabel = 1;
+    }
+
+    SensorFusion::SensorFusion(){
+        numSensors_ = 1;
+        mergeDistance_ = 50;
+    }
+
+    void SensorFusion::setup(int numSensors){
+        numSensors_ = numSensors;
+        objectLabels = Labels();
+        handLabels = Labels();
+    }
+
+    void SensorFusion::setMergeDistance(float distance){
+        mergeDistance_ = distance;
+    }
+
+    //--------------------------------------------------------------
+    void SensorFusion::fuse(const vector<const TrackingFrame*>& frames, const vector<bool>& isNew, const vector<ofMatrix4x4>& toTable, FusedFrame& fused){
+        fused.frameNumber = 0;
+        for (int s = 0; s < frames.size(); s++) {
+            fused.frameNumber = MAX(fused.frameNumber, frames[s]->frameNumber);
+        }
+
+        fuseBlobs(objectLabels, frames, toTable, true, fused.objectViews);
+        fuseBlobs(handLabels, frames, toTable, false, fused.handViews);
+        mergeViews(fused.objectViews, fused.objects);
+        mergeViews(fused.handViews, fused.hands);
+
+        fused.deadObjectLabels.clear();
+        fused.deadHandLabels.clear();
+        for (int s = 0; s < frames.size(); s++) {
+            if (isNew[s]) {
+                retire(objectLabels, s, frames[s]->deadObjectLabels, fused.deadObjectLabels);
+                retire(handLabels, s, frames[s]->deadHandLabels, fused.deadHandLabels);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------
+    void SensorFusion::fuseBlobs(Labels& labels, const vector<const TrackingFrame*>& frames, const vector<ofMatrix4x4>& toTable, bool objects, vector<TrackedBlob>& fused){
+        fused.clear();
+        pending.clear();
+
+        //Blobs already known, in table coordinates
+        for (int s = 0; s < frames.size(); s++) {
+            const vector<TrackedBlob>& blobs = objects ? frames[s]->objects : frames[s]->hands;
+            for (int i = 0; i < blobs.size(); i++) {
+                fused.push_back(blobs[i]);
+                TrackedBlob& blob = fused.back();
+                blob.sensor = s;
+                blob.worldCentroid = toTable[s].preMult(blob.worldCentroid);
+                for (int k = 0; k < blob.worldQuad.size(); k++) {
+                    blob.worldQuad[k] = toTable[s].preMult(blob.worldQuad[k]);
+                }
+
+                map<pair<int, unsigned int>, unsigned int>::iterator it = labels.globals.find(make_pair(s, blob.label));
+                if (it != labels.globals.end()) {
+                    blob.label = it->second;
+                } else {
+                    pending.push_back(fused.size() - 1);
+                }
+            }
+        }
+
+        //New blobs: take the label of the closest known blob of another sensor, if close enough
+        for (int p = 0; p < pending.size(); p++) {
+            TrackedBlob& blob = fused[pending[p]];
+            unsigned int local = blob.label;
+            unsigned int global = 0;
+            float closest = mergeDistance_ * mergeDistance_;
+            for (int i = 0; i < fused.size() && numSensors_ > 1; i++) {
+                bool known = find(pending.begin() + p, pending.end(), i) == pending.end();
+                if (known && fused[i].sensor != blob.sensor && fused[i].worldCentroid.squareDistance(blob.worldCentroid) < closest) {
+                    closest = fused[i].worldCentroid.squareDistance(blob.worldCentroid);
+                    global = fused[i].label;
+                }
+            }
+            if (global == 0) {
+                global = numSensors_ > 1 ? labels.nextLabel++ : local;
+            }
+            labels.globals[make_pair(blob.sensor, local)] = global;
+            labels.references[global]++;
+            blob.label = global;
+        }
+    }
+
+    //--------------------------------------------------------------
+    // Views come in sensor order, so the first of a label is the row. The
+    // others add to its means, each corner of the row taking the closest one
+    // of the view: sensors see the quad's corners in different orders.
+    void SensorFusion::mergeViews(const vector<TrackedBlob>& views, vector<TrackedBlob>& merged){
+        if (numSensors_ <= 1) {
+            merged = views;
+            return;
+        }
+        merged.clear();
+        rows.clear();
+        rowViews.clear();
+        for (int i = 0; i < views.size(); i++) {
+            const TrackedBlob& view = views[i];
+            map<unsigned int, int>::iterator it = rows.find(view.label);
+            if (it == rows.end()) {
+                rows[view.label] = merged.size();
+                merged.push_back(view);
+                rowViews.push_back(1);
+                continue;
+            }
+            TrackedBlob& row = merged[it->second];
+            float weight = 1.f / ++rowViews[it->second];
+            row.worldCentroid += (view.worldCentroid - row.worldCentroid) * weight;
+            for (int k = 0; k < row.worldQuad.size() && !view.worldQuad.empty(); k++) {
+                int closest = 0;
+                for (int c = 1; c < view.worldQuad.size(); c++) {
+                    if (view.worldQuad[c].squareDistance(row.worldQuad[k]) < view.worldQuad[closest].squareDistance(row.worldQuad[k])) {
+                        closest = c;
+                    }
+                }
+                row.worldQuad[k] += (view.worldQuad[closest] - row.worldQuad[k]) * weight;
+            }
+            row.minHeight = MIN(row.minHeight, view.minHeight);
+            row.maxHeight = MAX(row.maxHeight, view.maxHeight);
+            row.meanHeight += (view.meanHeight - row.meanHeight) * weight;
+        }
+    }
+
+    //--------------------------------------------------------------
+    void SensorFusion::retire(Labels& labels, int sensor, const vector<unsigned int>& deadLabels, vector<unsigned int>& fusedDead){
+        for (int i = 0; i < deadLabels.size(); i++) {
+            map<pair<int, unsigned int>, unsigned int>::iterator it = labels.globals.find(make_pair(sensor, deadLabels[i]));
+            //Unknown: never seen, or already reported
+            if (it == labels.globals.end()) {
+                continue;
+            }
+            unsigned int global = it->second;
+            labels.globals.erase(it);
+            if (--labels.references[global] <= 0) {
+                labels.references.erase(global);
+                fusedDead.push_back(global);
+            }
+        }
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,59 @@
+//
+//  ofxKinectObjectsFusion.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsPipeline.h"
+
+namespace ofxKinectObjects {
+
+    // One row per object and per hand, in table coordinates. A row's pixel
+    // centroid, quad and contour are those of the first sensor that sees it
+    // (TrackedBlob::sensor); the views keep every sensor's.
+    struct FusedFrame : public TrackingFrame{
+        vector<TrackedBlob> objectViews;
+        vector<TrackedBlob> handViews;
+    };
+
+    // Merges the tracking results of several sensors into one frame in table
+    // coordinates. Blobs get a global label: a blob first seen close (in table
+    // space) to a blob of another sensor takes that blob's label, so an object
+    // in the overlap region is one object seen twice, and is one row with the
+    // mean centroid and corners of both views. A global label dies when no
+    // sensor sees it any more.
+    class SensorFusion{
+    public:
+        SensorFusion();
+        //With a single sensor global labels are the tracker labels
+        void setup(int numSensors);
+        void setMergeDistance(float distance);
+
+        //frames[i] is sensor i's latest result, isNew[i] whether it wasn't fused before
+        void fuse(const vector<const TrackingFrame*>& frames, const vector<bool>& isNew, const vector<ofMatrix4x4>& toTable, FusedFrame& fused);
+
+    private:
+        struct Labels{
+            Labels();
+            map<pair<int, unsigned int>, unsigned int> globals;
+            map<unsigned int, int> references;
+            unsigned int nextLabel;
+        };
+
+        void fuseBlobs(Labels& labels, const vector<const TrackingFrame*>& frames, const vector<ofMatrix4x4>& toTable, bool objects, vector<TrackedBlob>& fused);
+        void mergeViews(const vector<TrackedBlob>& views, vector<TrackedBlob>& merged);
+        void retire(Labels& labels, int sensor, const vector<unsigned int>& deadLabels, vector<unsigned int>& fusedDead);
+
+        int numSensors_;
+        float mergeDistance_;
+        Labels objectLabels;
+        Labels handLabels;
+        vector<int> pending;
+        map<unsigned int, int> rows;
+        vector<int> rowViews;
+    };
+
+} //namespace ofxKinectObjects
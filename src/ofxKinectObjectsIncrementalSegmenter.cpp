@@ -0,0 +1,162 @@
+//
+//  ofxKinectObjectsIncrementalSegmenter.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsIncrementalSegmenter.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OFX_KINECT_OBJECTS_SSE2
+#endif
+
+namespace ofxKinectObjects {
+
+    //Some value of a is more than threshold away from the one in b
+    static bool rowChanged(const unsigned short* a, const unsigned short* b, int n, unsigned short threshold){
+        int i = 0;
+#ifdef OFX_KINECT_OBJECTS_SSE2
+        //|a - b| as the sum of both saturated differences, one of them 0
+        const __m128i limit = _mm_set1_epi16(threshold);
+        __m128i over = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+            __m128i difference = _mm_or_si128(_mm_subs_epu16(x, y), _mm_subs_epu16(y, x));
+            over = _mm_or_si128(over, _mm_subs_epu16(difference, limit));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(over, _mm_setzero_si128())) != 0xffff) {
+            return true;
+        }
+#endif
+        for (; i < n; i++) {
+            if (abs(a[i] - b[i]) > threshold) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool sameMasks(const cv::Mat& a, const cv::Mat& b){
+        for (int j = 0; j < a.rows; j++) {
+            if (memcmp(a.ptr<unsigned char>(j), b.ptr<unsigned char>(j), a.cols) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    IncrementalSegmenter::IncrementalSegmenter(){
+        tileSize_ = 32;
+        changeThreshold_ = 10;
+        segmenterVersion_ = 0;
+        step_ = 0;
+        sourceWidth_ = maskWidth_ = 0;
+        bObjectsChanged_ = bHandsChanged_ = false;
+        dirtyTiles_ = tiles_ = 0;
+    }
+
+    //--------------------------------------------------------------
+    void IncrementalSegmenter::setTileSize(int size){
+        tileSize_ = MAX(size, 4);
+    }
+
+    void IncrementalSegmenter::setChangeThreshold(float threshold){
+        changeThreshold_ = MAX(threshold, 0.f);
+    }
+
+    //--------------------------------------------------------------
+    void IncrementalSegmenter::segment(const unsigned short* depth, const DepthSegmenter& segmenter, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold, int step){
+        int width = segmenter.getMaskWidth(step), height = segmenter.getMaskHeight(step);
+        int columns = (width + tileSize_ - 1) / tileSize_, rows = (height + tileSize_ - 1) / tileSize_;
+        tiles_ = columns * rows;
+
+        // nothing to start from: the whole frame, as a reference for the next ones
+        if (segmenter.getVersion() != segmenterVersion_ || floorThreshold != floorThreshold_ || handsThreshold != handsThreshold_ || step != step_
+            || objectsMask.cols != width || objectsMask.rows != height || handsMask.cols != width || handsMask.rows != height) {
+            segmenter.segment(depth, objectsMask, handsMask, floorThreshold, handsThreshold, step);
+            segmenterVersion_ = segmenter.getVersion();
+            floorThreshold_ = floorThreshold;
+            handsThreshold_ = handsThreshold;
+            step_ = step;
+            sourceWidth_ = segmenter.getWidth();
+            maskWidth_ = width;
+            reference_.resize(width * height);
+            keepTile(depth, cv::Rect(0, 0, width, height));
+            bObjectsChanged_ = bHandsChanged_ = true;
+            dirtyTiles_ = tiles_;
+            return;
+        }
+
+        bObjectsChanged_ = bHandsChanged_ = false;
+        dirtyTiles_ = 0;
+        for (int ty = 0; ty < rows; ty++) {
+            for (int tx = 0; tx < columns; tx++) {
+                int x = tx * tileSize_, y = ty * tileSize_;
+                cv::Rect tile(x, y, MIN(tileSize_, width - x), MIN(tileSize_, height - y));
+                if (!isTileDirty(depth, tile)) {
+                    continue;
+                }
+                dirtyTiles_++;
+
+                // the masks before, to tell whether segmenting changed them
+                objectsMask(tile).copyTo(objectsTile);
+                handsMask(tile).copyTo(handsTile);
+                segmenter.segmentRect(depth, objectsMask, handsMask, floorThreshold, handsThreshold, step, tile);
+                bObjectsChanged_ = bObjectsChanged_ || !sameMasks(objectsTile, objectsMask(tile));
+                bHandsChanged_ = bHandsChanged_ || !sameMasks(handsTile, handsMask(tile));
+                keepTile(depth, tile);
+            }
+        }
+    }
+
+    bool IncrementalSegmenter::isTileDirty(const unsigned short* depth, const cv::Rect& tile){
+        unsigned short threshold = MIN(changeThreshold_, 65535.f);
+        sampledRow.resize(tile.width);
+        for (int j = tile.y; j < tile.y + tile.height; j++) {
+            const unsigned short* row = depth + j * step_ * sourceWidth_ + tile.x * step_;
+            //the sampled pixels, gathered so they can be compared 8 at a time
+            if (step_ > 1) {
+                for (int i = 0; i < tile.width; i++) {
+                    sampledRow[i] = row[i * step_];
+                }
+                row = &sampledRow[0];
+            }
+            if (rowChanged(row, &reference_[j * maskWidth_ + tile.x], tile.width, threshold)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void IncrementalSegmenter::keepTile(const unsigned short* depth, const cv::Rect& tile){
+        for (int j = tile.y; j < tile.y + tile.height; j++) {
+            const unsigned short* row = depth + j * step_ * sourceWidth_ + tile.x * step_;
+            unsigned short* referenceRow = &reference_[j * maskWidth_ + tile.x];
+            for (int i = 0; i < tile.width; i++) {
+                referenceRow[i] = row[i * step_];
+            }
+        }
+    }
+
+    //--------------------------------------------------------------
+    bool IncrementalSegmenter::hasObjectsChanged() const{
+        return bObjectsChanged_;
+    }
+
+    bool IncrementalSegmenter::hasHandsChanged() const{
+        return bHandsChanged_;
+    }
+
+    int IncrementalSegmenter::getDirtyTileCount() const{
+        return dirtyTiles_;
+    }
+
+    int IncrementalSegmenter::getTileCount() const{
+        return tiles_;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,56 @@
+//
+//  ofxKinectObjectsIncrementalSegmenter.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsSegmenter.h"
+
+namespace ofxKinectObjects {
+
+    // Keeps the masks between frames and segments again only the tiles whose
+    // depth changed. Each tile is compared with the depth it had when it was
+    // last segmented, not with the previous frame, so slow changes add up
+    // until they are seen. Everything is segmented again when the segmenter,
+    // the thresholds or the step change.
+    class IncrementalSegmenter{
+    public:
+        IncrementalSegmenter();
+        //Tile side in mask pixels
+        void setTileSize(int size);
+        //Depth change (mm) under which a pixel is kinect noise
+        void setChangeThreshold(float threshold);
+
+        void segment(const unsigned short* depth, const DepthSegmenter& segmenter, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold, int step = 1);
+
+        //What the last segment() did
+        bool hasObjectsChanged() const;
+        bool hasHandsChanged() const;
+        int getDirtyTileCount() const;
+        int getTileCount() const;
+
+    private:
+        bool isTileDirty(const unsigned short* depth, const cv::Rect& tile);
+        void keepTile(const unsigned short* depth, const cv::Rect& tile);
+
+        int tileSize_;
+        float changeThreshold_;
+
+        //What the masks were segmented with
+        unsigned long long segmenterVersion_;
+        ofVec2f floorThreshold_, handsThreshold_;
+        int step_;
+        int sourceWidth_, maskWidth_;
+
+        //Depth of the mask pixels when their tile was last segmented
+        vector<unsigned short> reference_;
+        vector<unsigned short> sampledRow;
+        cv::Mat objectsTile, handsTile;
+        bool bObjectsChanged_, bHandsChanged_;
+        int dirtyTiles_, tiles_;
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,193 @@
+//
+//  ofxKinectObjectsLabeler.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsLabeler.h"
+
+namespace ofxKinectObjects {
+
+    LabeledBlob::LabeledBlob(){
+        area = 0;
+        minDistance = maxDistance = meanDistance = 0;
+    }
+
+    void BlobLabeler::Moments::clear(int x, int y){
+        count = 0;
+        sumX = sumY = sumXX = sumXY = sumYY = sumDistance = 0;
+        minX = maxX = x;
+        minY = maxY = y;
+        minDistance = FLT_MAX;
+        maxDistance = 0;
+    }
+
+    void BlobLabeler::Moments::add(int x, int y, float distance){
+        count++;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        sumYY += y * y;
+        sumDistance += distance;
+        minX = MIN(minX, x);
+        maxX = MAX(maxX, x);
+        maxY = y;
+        minDistance = MIN(minDistance, distance);
+        maxDistance = MAX(maxDistance, distance);
+    }
+
+    void BlobLabeler::Moments::merge(const Moments& other){
+        count += other.count;
+        sumX += other.sumX;
+        sumY += other.sumY;
+        sumXX += other.sumXX;
+        sumXY += other.sumXY;
+        sumYY += other.sumYY;
+        sumDistance += other.sumDistance;
+        minX = MIN(minX, other.minX);
+        minY = MIN(minY, other.minY);
+        maxX = MAX(maxX, other.maxX);
+        maxY = MAX(maxY, other.maxY);
+        minDistance = MIN(minDistance, other.minDistance);
+        maxDistance = MAX(maxDistance, other.maxDistance);
+    }
+
+    //--------------------------------------------------------------
+    int BlobLabeler::newLabel(int blobClass, int x, int y){
+        int label = parents.size();
+        parents.push_back(label);
+        moments.push_back(Moments());
+        moments.back().clear(x, y);
+        moments.back().blobClass = blobClass;
+        return label;
+    }
+
+    //With path halving
+    int BlobLabeler::findRoot(int label){
+        while (parents[label] != label) {
+            parents[label] = parents[parents[label]];
+            label = parents[label];
+        }
+        return label;
+    }
+
+    //The smaller label stays the root, so roots come before their children
+    int BlobLabeler::join(int a, int b){
+        a = findRoot(a);
+        b = findRoot(b);
+        if (a < b) {
+            parents[b] = a;
+            return a;
+        }
+        parents[a] = b;
+        return b;
+    }
+
+    //--------------------------------------------------------------
+    void BlobLabeler::label(const unsigned short* depth, const DepthSegmenter& segmenter, ofVec2f floorThreshold, ofVec2f handsThreshold, int step){
+        int width = segmenter.getMaskWidth(step), height = segmenter.getMaskHeight(step);
+        int sourceWidth = segmenter.getWidth();
+        objectsMask.create(height, width, CV_8UC1);
+        handsMask.create(height, width, CV_8UC1);
+        previousRow.assign(width + 2, -1);
+        currentRow.assign(width + 2, -1);
+        parents.clear();
+        moments.clear();
+
+        for (int j = 0; j < height; j++) {
+            segmenter.segmentRect(depth, objectsMask, handsMask, floorThreshold, handsThreshold, step, cv::Rect(0, j, width, 1));
+            const unsigned char* objectsRow = objectsMask.ptr<unsigned char>(j);
+            const unsigned char* handsRow = handsMask.ptr<unsigned char>(j);
+            const unsigned short* depthRow = depth + j * step * sourceWidth;
+
+            //Rows are padded with a -1 at both ends: pixel i is at i + 1
+            for (int i = 0; i < width; i++) {
+                if (!objectsRow[i] && !handsRow[i]) {
+                    currentRow[i + 1] = -1;
+                    continue;
+                }
+                int blobClass = objectsRow[i] ? BLOB_OBJECT : BLOB_HAND;
+
+                //Left, up left, up and up right
+                int label = -1;
+                int neighbours[4] = {currentRow[i], previousRow[i], previousRow[i + 1], previousRow[i + 2]};
+                for (int k = 0; k < 4; k++) {
+                    int neighbour = neighbours[k];
+                    if (neighbour < 0 || moments[neighbour].blobClass != blobClass) {
+                        continue;
+                    }
+                    label = label < 0 ? findRoot(neighbour) : join(label, neighbour);
+                }
+                if (label < 0) {
+                    label = newLabel(blobClass, i, j);
+                }
+                currentRow[i + 1] = label;
+
+                int x = i * step, y = j * step;
+                moments[label].add(i, j, segmenter.getDistanceToBackground(depthRow[x], x, y));
+            }
+            previousRow.swap(currentRow);
+        }
+
+        //Every provisional label into its root
+        for (int k = 0; k < BLOB_CLASS_COUNT; k++) {
+            blobs[k].clear();
+        }
+        for (int label = 0; label < parents.size(); label++) {
+            int root = findRoot(label);
+            if (root != label) {
+                moments[root].merge(moments[label]);
+            }
+        }
+        for (int label = 0; label < parents.size(); label++) {
+            if (parents[label] == label) {
+                vector<LabeledBlob>& classBlobs = blobs[moments[label].blobClass];
+                classBlobs.push_back(LabeledBlob());
+                fillBlob(moments[label], classBlobs.back());
+            }
+        }
+    }
+
+    //--------------------------------------------------------------
+    // A uniform w x h rectangle has variances w^2 / 12 and h^2 / 12 along its
+    // axes, which are the eigenvectors of the covariance of its pixels.
+    void BlobLabeler::fillBlob(const Moments& m, LabeledBlob& blob) const{
+        double n = m.count;
+        double cx = m.sumX / n, cy = m.sumY / n;
+        double xx = m.sumXX / n - cx * cx, xy = m.sumXY / n - cx * cy, yy = m.sumYY / n - cy * cy;
+        double angle = 0.5 * atan2(2 * xy, xx - yy);
+        double spread = sqrt((xx - yy) * (xx - yy) / 4 + xy * xy);
+        double major = sqrt(3 * MAX((xx + yy) / 2 + spread, 0.0));
+        double minor = sqrt(3 * MAX((xx + yy) / 2 - spread, 0.0));
+        ofPoint u(cos(angle) * major, sin(angle) * major), v(-sin(angle) * minor, cos(angle) * minor);
+
+        blob.area = m.count;
+        blob.centroid = ofPoint(cx, cy);
+        blob.quad.resize(4);
+        blob.quad[0] = blob.centroid + u + v;
+        blob.quad[1] = blob.centroid - u + v;
+        blob.quad[2] = blob.centroid - u - v;
+        blob.quad[3] = blob.centroid + u - v;
+        blob.boundingRect = cv::Rect(m.minX, m.minY, m.maxX - m.minX + 1, m.maxY - m.minY + 1);
+        blob.minDistance = m.minDistance;
+        blob.maxDistance = m.maxDistance;
+        blob.meanDistance = m.sumDistance / n;
+    }
+
+    //--------------------------------------------------------------
+    const vector<LabeledBlob>& BlobLabeler::getBlobs(BlobClass blobClass) const{
+        return blobs[blobClass];
+    }
+
+    const cv::Mat& BlobLabeler::getObjectsMask() const{
+        return objectsMask;
+    }
+
+    const cv::Mat& BlobLabeler::getHandsMask() const{
+        return handsMask;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,70 @@
+//
+//  ofxKinectObjectsLabeler.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsSegmenter.h"
+
+namespace ofxKinectObjects {
+
+    enum BlobClass{
+        BLOB_OBJECT,
+        BLOB_HAND,
+        BLOB_CLASS_COUNT
+    };
+
+    //A connected component of one class, in mask pixels
+    struct LabeledBlob{
+        LabeledBlob();
+        int area;
+        ofPoint centroid;
+        //Rectangle with the same second moments as the blob
+        vector<ofPoint> quad;
+        cv::Rect boundingRect;
+        //Distance to the background of the blob's pixels (mm)
+        float minDistance, maxDistance, meanDistance;
+    };
+
+    // Segments the depth and finds the 8-connected objects and hands in the
+    // same sweep. Each row is classified as DepthSegmenter::segment() does
+    // and labeled while it is still in cache, against the labels of the row
+    // above, with union-find. Moments, bounding box and distance range of each
+    // provisional label add up as the pixels come, and are merged once at
+    // the end, so no contour is ever traced.
+    class BlobLabeler{
+    public:
+        void label(const unsigned short* depth, const DepthSegmenter& segmenter, ofVec2f floorThreshold, ofVec2f handsThreshold, int step = 1);
+        const vector<LabeledBlob>& getBlobs(BlobClass blobClass) const;
+        //Masks of the last label(), as segment() would have written them
+        const cv::Mat& getObjectsMask() const;
+        const cv::Mat& getHandsMask() const;
+
+    private:
+        struct Moments{
+            void clear(int x, int y);
+            void add(int x, int y, float distance);
+            void merge(const Moments& other);
+            int blobClass;
+            int count;
+            double sumX, sumY, sumXX, sumXY, sumYY, sumDistance;
+            int minX, minY, maxX, maxY;
+            float minDistance, maxDistance;
+        };
+
+        int newLabel(int blobClass, int x, int y);
+        int findRoot(int label);
+        int join(int a, int b);
+        void fillBlob(const Moments& moments, LabeledBlob& blob) const;
+
+        cv::Mat objectsMask, handsMask;
+        vector<int> previousRow, currentRow;
+        vector<int> parents;
+        vector<Moments> moments;
+        vector<LabeledBlob> blobs[BLOB_CLASS_COUNT];
+    };
+
+} //namespace ofxKinectObjects
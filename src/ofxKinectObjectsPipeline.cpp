@@ -0,0 +1,516 @@
+//
+//  ofxKinectObjectsPipeline.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsPipeline.h"
+#include <cfloat>
+
+namespace ofxKinectObjects {
+
+    //ofxCv's default tracker distance, in full resolution pixels
+    static const float trackerDistance = 64;
+
+    //Object refreshes shed in a row before one runs over the budget anyway, and
+    //how much the cost estimate drops with each, so one slow refresh doesn't
+    //keep the rest out
+    static const int maxShedRefreshes = 15;
+    static const float shedCostDecay = 0.9f;
+
+    //Set on the labels of single pass labeling, so they are never those of
+    //the contour finders
+    static const unsigned int labeledLabelTag = 0x40000000;
+
+    //Every ratio-th pixel of every ratio-th row
+    static void decimateMask(const cv::Mat& mask, int ratio, cv::Mat& decimated){
+        decimated.create((mask.rows + ratio - 1) / ratio, (mask.cols + ratio - 1) / ratio, CV_8UC1);
+        for (int j = 0; j < decimated.rows; j++) {
+            const unsigned char* row = mask.ptr<unsigned char>(j * ratio);
+            unsigned char* decimatedRow = decimated.ptr<unsigned char>(j);
+            for (int i = 0; i < decimated.cols; i++) {
+                decimatedRow[i] = row[i * ratio];
+            }
+        }
+    }
+
+    //Pixels of the objects mask that are not as in reference, leaving out those
+    //under a hand now. Stops counting past limit.
+    static int countObjectChanges(const cv::Mat& objects, const cv::Mat& reference, const cv::Mat& hands, int objectsStep, int handsStep, int limit){
+        int changes = 0;
+        for (int j = 0; j < objects.rows && changes <= limit; j++) {
+            const unsigned char* row = objects.ptr<unsigned char>(j);
+            const unsigned char* referenceRow = reference.ptr<unsigned char>(j);
+            const unsigned char* handsRow = hands.ptr<unsigned char>(MIN(j * objectsStep / handsStep, hands.rows - 1));
+            for (int i = 0; i < objects.cols; i++) {
+                if (row[i] != referenceRow[i] && !handsRow[MIN(i * objectsStep / handsStep, hands.cols - 1)]) {
+                    changes++;
+                }
+            }
+        }
+        return changes;
+    }
+
+    //Labels the finder lost, but may still find again before giving up on them
+    static void updatePendingLabels(const vector<TrackedBlob>& blobs, const vector<unsigned int>& dead, vector<unsigned int>& found, vector<unsigned int>& pending){
+        vector<unsigned int> current(blobs.size());
+        for (int i = 0; i < blobs.size(); i++) {
+            current[i] = blobs[i].label;
+        }
+        for (int i = 0; i < found.size(); i++) {
+            if (find(current.begin(), current.end(), found[i]) == current.end() && find(pending.begin(), pending.end(), found[i]) == pending.end()) {
+                pending.push_back(found[i]);
+            }
+        }
+        for (int i = pending.size() - 1; i >= 0; i--) {
+            if (find(current.begin(), current.end(), pending[i]) != current.end() || find(dead.begin(), dead.end(), pending[i]) != dead.end()) {
+                pending.erase(pending.begin() + i);
+            }
+        }
+        found.swap(current);
+    }
+
+    //Distance to the background of the blob's pixels: those set in the mask
+    //within its bounding rect, as the labeler measures them
+    static void measureHeights(const cv::Mat& mask, const cv::Rect& rect, int step, const unsigned short* depth, const DepthSegmenter& segmenter, TrackedBlob& blob){
+        int width = segmenter.getWidth();
+        float sum = 0;
+        int count = 0;
+        blob.minHeight = FLT_MAX;
+        blob.maxHeight = 0;
+        for (int j = MAX(rect.y, 0); j < MIN(rect.y + rect.height, mask.rows); j++) {
+            const unsigned char* row = mask.ptr<unsigned char>(j);
+            for (int i = MAX(rect.x, 0); i < MIN(rect.x + rect.width, mask.cols); i++) {
+                if (!row[i]) {
+                    continue;
+                }
+                float distance = segmenter.getDistanceToBackground(depth[j * step * width + i * step], i * step, j * step);
+                blob.minHeight = MIN(blob.minHeight, distance);
+                blob.maxHeight = MAX(blob.maxHeight, distance);
+                sum += distance;
+                count++;
+            }
+        }
+        if (count == 0) {
+            blob.minHeight = 0;
+        }
+        blob.meanHeight = count > 0 ? sum / count : 0;
+    }
+
+    //Labels given and not dead yet
+    static void updateLiveLabels(const vector<TrackedBlob>& blobs, const vector<unsigned int>& dead, vector<unsigned int>& live){
+        for (int i = 0; i < blobs.size(); i++) {
+            if (find(live.begin(), live.end(), blobs[i].label) == live.end()) {
+                live.push_back(blobs[i].label);
+            }
+        }
+        for (int i = 0; i < dead.size(); i++) {
+            live.erase(remove(live.begin(), live.end(), dead[i]), live.end());
+        }
+    }
+
+    static void tagLabels(const vector<unsigned int>& labels, vector<unsigned int>& tagged){
+        tagged.resize(labels.size());
+        for (int i = 0; i < labels.size(); i++) {
+            tagged[i] = labels[i] | labeledLabelTag;
+        }
+    }
+
+    DetectionSettings::DetectionSettings(){
+        objectsDecimation = 1;
+        handsDecimation = 1;
+        objectsInterval = 1;
+        objectsChangeArea = 0;
+        frameBudget = 0;
+        tileSize = 0;
+        changeThreshold = 10;
+        singlePassLabeling = false;
+        keepMasks = true;
+    }
+
+    DepthFrame::DepthFrame(){
+        frameNumber = 0;
+    }
+
+    TrackedBlob::TrackedBlob(){
+        label = 0;
+        sensor = 0;
+        minHeight = maxHeight = meanHeight = 0;
+    }
+
+    TrackingFrame::TrackingFrame(){
+        frameNumber = 0;
+        bObjectsRefreshed = bObjectsShed = false;
+    }
+
+    /***
+     DETECTION PIPELINE
+     **___________________________________*/
+
+    DetectionPipeline::DetectionPipeline(){
+        objectsSegmenterVersion = 0;
+        framesSinceObjects = 0;
+        objectsCost = 0;
+        objectsShed = 0;
+        bObjectsMaskChanged = true;
+        bHandsFound = false;
+        bSinglePassLabeling = false;
+    }
+
+    void DetectionPipeline::process(const unsigned short* depth, const DepthSegmenter& segmenter, const DetectionSettings& settings, TrackingFrame& frame){
+        frame.times.clear();
+        if (settings.singlePassLabeling != bSinglePassLabeling) {
+            switchPath(settings.singlePassLabeling);
+        }
+        if (settings.singlePassLabeling) {
+            labelBlobs(depth, segmenter, settings, frame);
+        } else {
+            traceBlobs(depth, segmenter, settings, frame);
+        }
+
+        updateLiveLabels(frame.objects, frame.deadObjectLabels, liveObjects);
+        updateLiveLabels(frame.hands, frame.deadHandLabels, liveHands);
+        frame.deadObjectLabels.insert(frame.deadObjectLabels.end(), retiredObjects.begin(), retiredObjects.end());
+        frame.deadHandLabels.insert(frame.deadHandLabels.end(), retiredHands.begin(), retiredHands.end());
+        retiredObjects.clear();
+        retiredHands.clear();
+    }
+
+    //--------------------------------------------------------------
+    // The path left behind won't report its labels dead: they die now, and
+    // its trackers start over for when it runs again
+    void DetectionPipeline::switchPath(bool singlePassLabeling){
+        retiredObjects.swap(liveObjects);
+        retiredHands.swap(liveHands);
+        liveObjects.clear();
+        liveHands.clear();
+        if (singlePassLabeling) {
+            objectsFinder.getTracker() = ofxCv::RectTracker();
+            handsFinder.getTracker() = ofxCv::RectTracker();
+            objects.clear();
+            hands.clear();
+            objectsFound.clear();
+            objectsPending.clear();
+            handsFound.clear();
+            handsPending.clear();
+        } else {
+            objectsTracker = ofxCv::RectTracker();
+            handsTracker = ofxCv::RectTracker();
+        }
+        bSinglePassLabeling = singlePassLabeling;
+    }
+
+    //--------------------------------------------------------------
+    void DetectionPipeline::traceBlobs(const unsigned short* depth, const DepthSegmenter& segmenter, const DetectionSettings& settings, TrackingFrame& frame){
+        unsigned long long start = ofGetElapsedTimeMicros();
+
+        // both masks in one pass at the finer of the two steps, consumed by the
+        // contour finders as they are. The other detector samples its mask.
+        // Incremental: only the tiles whose depth changed.
+        int objectsStep = settings.objectsDecimation, handsStep = settings.handsDecimation;
+        int step = MIN(objectsStep, handsStep);
+        bool bIncremental = settings.tileSize > 0;
+        bool bObjectsChanged = true, bHandsChanged = true;
+        {
+            ScopedStageTimer timer(frame.times, STAGE_SEGMENTATION);
+            if (bIncremental) {
+                incremental.setTileSize(settings.tileSize);
+                incremental.setChangeThreshold(settings.changeThreshold);
+                incremental.segment(depth, segmenter, objectsMask, handsMask, settings.floorThreshold, settings.handsThreshold, step);
+                bObjectsChanged = incremental.hasObjectsChanged();
+                bHandsChanged = incremental.hasHandsChanged();
+            } else {
+                segmenter.segment(depth, objectsMask, handsMask, settings.floorThreshold, settings.handsThreshold, step);
+            }
+            if (objectsStep > step) {
+                decimateMask(objectsMask, objectsStep / step, decimatedMask);
+            } else if (handsStep > step) {
+                decimateMask(handsMask, handsStep / step, decimatedMask);
+            }
+        }
+        cv::Mat& objectsInput = objectsStep > step ? decimatedMask : objectsMask;
+        cv::Mat& handsInput = handsStep > step ? decimatedMask : handsMask;
+
+        // hands on every frame, before anything that can be shed. The same mask
+        // gives the same blobs: if it didn't change and no lost hand can still
+        // die, the last ones hold.
+        bObjectsMaskChanged = bObjectsMaskChanged || bObjectsChanged || !bIncremental;
+        bool bHandsHold = bIncremental && !bHandsChanged && bHandsFound && handsPending.empty()
+            && settings.handsBlobSize == handsSettings.handsBlobSize && settings.handsDecimation == handsSettings.handsDecimation;
+        if (bHandsHold) {
+            frame.hands = hands;
+            frame.deadHandLabels.clear();
+        } else {
+            {
+                ScopedStageTimer timer(frame.times, STAGE_HAND_CONTOURS);
+                findBlobs(handsFinder, handsInput, handsStep, settings.handsBlobSize, depth, segmenter, frame.hands);
+            }
+            frame.deadHandLabels = handsFinder.getTracker().getDeadLabels();
+            if (bIncremental) {
+                updatePendingLabels(frame.hands, frame.deadHandLabels, handsFound, handsPending);
+                hands = frame.hands;
+                handsSettings = settings;
+                bHandsFound = true;
+            }
+        }
+
+        // objects when due and if the budget has room for them. A refresh left
+        // out stays due, so it runs on the next frame that is light enough, or
+        // after maxShedRefreshes frames whatever it costs.
+        frame.bObjectsRefreshed = frame.bObjectsShed = false;
+        bool bForced = isObjectsRefreshForced(segmenter, settings, objectsInput) || objectsShed >= maxShedRefreshes;
+        if (bForced || isObjectsRefreshDue(settings, objectsInput, handsInput)) {
+            float elapsed = ofGetElapsedTimeMicros() - start;
+            if (bForced || settings.frameBudget <= 0 || elapsed + objectsCost <= settings.frameBudget) {
+                unsigned long long objectsStart = ofGetElapsedTimeMicros();
+                {
+                    ScopedStageTimer timer(frame.times, STAGE_OBJECT_CONTOURS);
+                    findBlobs(objectsFinder, objectsInput, objectsStep, settings.objectsBlobSize, depth, segmenter, frame.objects);
+                }
+                float cost = ofGetElapsedTimeMicros() - objectsStart;
+                objectsCost = objectsCost == 0 ? cost : ofLerp(objectsCost, cost, 0.2f);
+                frame.deadObjectLabels = objectsFinder.getTracker().getDeadLabels();
+                frame.bObjectsRefreshed = true;
+                updatePendingLabels(frame.objects, frame.deadObjectLabels, objectsFound, objectsPending);
+                bObjectsMaskChanged = false;
+
+                objects = frame.objects;
+                objectsSegmenterVersion = segmenter.getVersion();
+                objectsSettings = settings;
+                if (settings.objectsChangeArea > 0) {
+                    objectsInput.copyTo(objectsReference);
+                }
+                framesSinceObjects = 0;
+                objectsShed = 0;
+            } else {
+                frame.bObjectsShed = true;
+                objectsShed++;
+                objectsCost *= shedCostDecay;
+            }
+        }
+        if (!frame.bObjectsRefreshed) {
+            frame.objects = objects;
+            frame.deadObjectLabels.clear();
+            framesSinceObjects++;
+        }
+
+        if (settings.keepMasks) {
+            objectsInput.copyTo(frame.objectsMask);
+            handsInput.copyTo(frame.handsMask);
+        } else {
+            frame.objectsMask.release();
+            frame.handsMask.release();
+        }
+    }
+
+    //--------------------------------------------------------------
+    //The last objects don't hold: first frame, new calibration or new object settings
+    bool DetectionPipeline::isObjectsRefreshForced(const DepthSegmenter& segmenter, const DetectionSettings& settings, const cv::Mat& objectsInput){
+        return objectsSegmenterVersion != segmenter.getVersion()
+            || settings.floorThreshold != objectsSettings.floorThreshold
+            || settings.objectsBlobSize != objectsSettings.objectsBlobSize
+            || settings.objectsDecimation != objectsSettings.objectsDecimation
+            || (settings.objectsChangeArea > 0 && objectsReference.size() != objectsInput.size());
+    }
+
+    bool DetectionPipeline::isObjectsRefreshDue(const DetectionSettings& settings, const cv::Mat& objectsInput, const cv::Mat& handsInput){
+        //Same mask as last time and no lost object that can still die: same objects
+        if (!bObjectsMaskChanged && objectsPending.empty()) {
+            return false;
+        }
+        if (framesSinceObjects + 1 >= settings.objectsInterval) {
+            return true;
+        }
+        if (settings.objectsChangeArea <= 0) {
+            return false;
+        }
+        int step = settings.objectsDecimation;
+        int limit = settings.objectsChangeArea / (step * step);
+        return countObjectChanges(objectsInput, objectsReference, handsInput, step, settings.handsDecimation, limit) > limit;
+    }
+
+    void DetectionPipeline::findBlobs(ofxCv::ContourFinder& finder, cv::Mat& mask, int step, ofVec2f blobSize, const unsigned short* depth, const DepthSegmenter& segmenter, vector<TrackedBlob>& blobs){
+        // areas and distances of the mask pixels, step x step kinect pixels each
+        finder.setMinArea(blobSize.x / (step * step));
+        finder.setMaxArea(blobSize.y / (step * step));
+        finder.getTracker().setMaximumDistance(trackerDistance / step);
+        finder.findContours(mask);
+        collectBlobs(finder, mask, step, depth, segmenter, blobs);
+    }
+
+    void DetectionPipeline::collectBlobs(ofxCv::ContourFinder& finder, const cv::Mat& mask, int step, const unsigned short* depth, const DepthSegmenter& segmenter, vector<TrackedBlob>& blobs){
+        blobs.resize(finder.size());
+        for (int i = 0; i < finder.size(); ++i) {
+            TrackedBlob& blob = blobs[i];
+            blob.label = finder.getLabel(i);
+
+            cv::Point2f centroid = finder.getCentroid(i);
+            blob.centroid = ofPoint(centroid.x * step, centroid.y * step);
+            blob.worldCentroid = segmenter.getWorldCoordinateAt(depth, blob.centroid.x, blob.centroid.y);
+
+            vector<cv::Point> quad = finder.getFitQuad(i);
+            blob.quad.resize(quad.size());
+            blob.worldQuad.resize(quad.size());
+            for (int k = 0; k < quad.size(); k++) {
+                blob.quad[k] = ofPoint(quad[k].x * step, quad[k].y * step);
+                blob.worldQuad[k] = segmenter.getWorldCoordinateAt(depth, quad[k].x * step, quad[k].y * step);
+            }
+
+            cv::Rect boundingRect = finder.getBoundingRect(i);
+            blob.boundingRect.set(boundingRect.x * step, boundingRect.y * step, boundingRect.width * step, boundingRect.height * step);
+            measureHeights(mask, boundingRect, step, depth, segmenter, blob);
+            blob.contour = finder.getPolyline(i);
+            if (step > 1) {
+                vector<ofPoint>& vertices = blob.contour.getVertices();
+                for (int k = 0; k < vertices.size(); k++) {
+                    vertices[k] *= step;
+                }
+            }
+        }
+    }
+
+    //--------------------------------------------------------------
+    // Both kinds of blobs come out of the labeler with their statistics, so
+    // there is nothing left to do but filter and track them
+    void DetectionPipeline::labelBlobs(const unsigned short* depth, const DepthSegmenter& segmenter, const DetectionSettings& settings, TrackingFrame& frame){
+        int step = MIN(settings.objectsDecimation, settings.handsDecimation);
+        {
+            ScopedStageTimer timer(frame.times, STAGE_SEGMENTATION);
+            labeler.label(depth, segmenter, settings.floorThreshold, settings.handsThreshold, step);
+        }
+        {
+            ScopedStageTimer timer(frame.times, STAGE_HAND_CONTOURS);
+            trackBlobs(handsTracker, labeler.getBlobs(BLOB_HAND), step, settings.handsBlobSize, depth, segmenter, frame.hands);
+        }
+        tagLabels(handsTracker.getDeadLabels(), frame.deadHandLabels);
+        {
+            ScopedStageTimer timer(frame.times, STAGE_OBJECT_CONTOURS);
+            trackBlobs(objectsTracker, labeler.getBlobs(BLOB_OBJECT), step, settings.objectsBlobSize, depth, segmenter, frame.objects);
+        }
+        tagLabels(objectsTracker.getDeadLabels(), frame.deadObjectLabels);
+        frame.bObjectsRefreshed = true;
+        frame.bObjectsShed = false;
+
+        //Whatever the contour path kept is stale if it runs again
+        objectsSegmenterVersion = 0;
+        objectsShed = 0;
+        bHandsFound = false;
+        bObjectsMaskChanged = true;
+
+        if (settings.keepMasks) {
+            labeler.getObjectsMask().copyTo(frame.objectsMask);
+            labeler.getHandsMask().copyTo(frame.handsMask);
+        } else {
+            frame.objectsMask.release();
+            frame.handsMask.release();
+        }
+    }
+
+    void DetectionPipeline::trackBlobs(ofxCv::RectTracker& tracker, const vector<LabeledBlob>& labeled, int step, ofVec2f blobSize, const unsigned short* depth, const DepthSegmenter& segmenter, vector<TrackedBlob>& blobs){
+        trackedRects.clear();
+        trackedBlobs.clear();
+        for (int i = 0; i < labeled.size(); i++) {
+            float area = labeled[i].area * step * step;
+            if (area >= blobSize.x && area <= blobSize.y) {
+                trackedRects.push_back(labeled[i].boundingRect);
+                trackedBlobs.push_back(i);
+            }
+        }
+        tracker.setMaximumDistance(trackerDistance / step);
+        const vector<unsigned int>& labels = tracker.track(trackedRects);
+
+        blobs.resize(trackedBlobs.size());
+        for (int i = 0; i < trackedBlobs.size(); i++) {
+            const LabeledBlob& source = labeled[trackedBlobs[i]];
+            TrackedBlob& blob = blobs[i];
+            blob.label = labels[i] | labeledLabelTag;
+
+            blob.centroid = source.centroid * step;
+            blob.worldCentroid = segmenter.getWorldCoordinateAt(depth, blob.centroid.x, blob.centroid.y);
+            blob.quad.resize(source.quad.size());
+            blob.worldQuad.resize(source.quad.size());
+            blob.contour.clear();
+            for (int k = 0; k < source.quad.size(); k++) {
+                blob.quad[k] = source.quad[k] * step;
+                blob.worldQuad[k] = segmenter.getWorldCoordinateAt(depth, blob.quad[k].x, blob.quad[k].y);
+                blob.contour.addVertex(blob.quad[k]);
+            }
+            blob.contour.close();
+
+            const cv::Rect& boundingRect = source.boundingRect;
+            blob.boundingRect.set(boundingRect.x * step, boundingRect.y * step, boundingRect.width * step, boundingRect.height * step);
+            blob.minHeight = source.minDistance;
+            blob.maxHeight = source.maxDistance;
+            blob.meanHeight = source.meanDistance;
+        }
+    }
+
+    /***
+     PIPELINE THREAD
+     **___________________________________*/
+
+    PipelineThread::PipelineThread(){
+        pipeline_ = NULL;
+        depthFrames_ = NULL;
+        trackingFrames_ = NULL;
+    }
+
+    void PipelineThread::setup(DetectionPipeline* pipeline, TripleBuffer<DepthFrame>* depthFrames, TripleBuffer<TrackingFrame>* trackingFrames){
+        pipeline_ = pipeline;
+        depthFrames_ = depthFrames;
+        trackingFrames_ = trackingFrames;
+    }
+
+    //--------------------------------------------------------------
+    void PipelineThread::start(){
+        startThread();
+    }
+
+    void PipelineThread::stop(){
+        stopThread();
+        notifyFrame();
+        waitForThread(false);
+    }
+
+    void PipelineThread::notifyFrame(){
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+
+    //--------------------------------------------------------------
+    void PipelineThread::threadedFunction(){
+        while (isThreadRunning()) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                while (isThreadRunning() && !depthFrames_->isPending()) {
+                    wakeCondition.wait(lock);
+                }
+            }
+            if (!depthFrames_->consume()) {
+                continue;
+            }
+
+            DepthFrame& input = depthFrames_->getFront();
+            if (!input.segmenter) {
+                continue;
+            }
+            TrackingFrame& output = trackingFrames_->getBack();
+            pipeline_->process(&input.depth[0], *input.segmenter, input.settings, output);
+            output.frameNumber = input.frameNumber;
+
+            // The last result was not read yet and is about to be replaced: keep
+            // its dead labels. If it gets read meanwhile they are reported twice,
+            // which is harmless, instead of never.
+            if (trackingFrames_->isPending()) {
+                output.deadObjectLabels.insert(output.deadObjectLabels.end(), carriedObjectLabels.begin(), carriedObjectLabels.end());
+                output.deadHandLabels.insert(output.deadHandLabels.end(), carriedHandLabels.begin(), carriedHandLabels.end());
+            }
+            carriedObjectLabels = output.deadObjectLabels;
+            carriedHandLabels = output.deadHandLabels;
+            trackingFrames_->publish();
+        }
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,193 @@
+//
+//  ofxKinectObjectsPipeline.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include "ofxCv.h"
+#include "ofxKinectObjectsSegmenter.h"
+#include "ofxKinectObjectsIncrementalSegmenter.h"
+#include "ofxKinectObjectsLabeler.h"
+#include "ofxKinectObjectsTripleBuffer.h"
+#include "ofxKinectObjectsStats.h"
+
+namespace ofxKinectObjects {
+
+    struct DetectionSettings{
+        DetectionSettings();
+        ofVec2f floorThreshold;
+        ofVec2f handsThreshold;
+        ofVec2f objectsBlobSize;
+        ofVec2f handsBlobSize;
+        //Each detector works on every n-th pixel of every n-th row: 1, 2 or 4.
+        //Blob sizes are in full resolution pixels either way.
+        int objectsDecimation;
+        int handsDecimation;
+        //Objects are nearly static: find them at least every objectsInterval
+        //frames (1, every frame) and sooner when more than objectsChangeArea
+        //full resolution pixels of their mask changed, not counting pixels
+        //under hands (0, never). Hands are found on every frame.
+        int objectsInterval;
+        float objectsChangeArea;
+        //Microseconds a frame may take. An object refresh that would not fit
+        //waits for a lighter frame, for a few frames at most; hands always
+        //run. 0, no budget.
+        float frameBudget;
+        //Incremental segmentation: split the masks in tiles of tileSize mask
+        //pixels and segment only those whose depth changed more than
+        //changeThreshold (mm). 0, the whole frame every time. Only segmentation
+        //is incremental: a mask with any changed tile has its contours found
+        //all over again, one that didn't change keeps its blobs.
+        int tileSize;
+        float changeThreshold;
+        //Find the blobs while segmenting (BlobLabeler) instead of tracing their
+        //contours, both at the finer decimation. Blobs get their heights, and
+        //their quad as contour. Schedule and tiles don't apply. Its labels are
+        //never the contour finders', and those of the path switched away from
+        //are reported dead.
+        bool singlePassLabeling;
+        //Copy the masks into the TrackingFrame, for drawing
+        bool keepMasks;
+    };
+
+    //Input of the pipeline: one kinect depth frame (mm) and what to do with it
+    struct DepthFrame{
+        DepthFrame();
+        unsigned long long frameNumber;
+        vector<unsigned short> depth;
+        shared_ptr<const DepthSegmenter> segmenter;
+        DetectionSettings settings;
+    };
+
+    //A blob found by one of the contour finders, in kinect pixel and world coordinates
+    struct TrackedBlob{
+        TrackedBlob();
+        unsigned int label;
+        //index of the sensor that saw it, set by SensorFusion
+        int sensor;
+        ofPoint centroid;
+        vector<ofPoint> quad;
+        ofRectangle boundingRect;
+        ofPolyline contour;
+        ofVec3f worldCentroid;
+        vector<ofVec3f> worldQuad;
+        //Distance of its pixels to the background (mm)
+        float minHeight, maxHeight, meanHeight;
+    };
+
+    //Output of the pipeline for one depth frame
+    struct TrackingFrame{
+        TrackingFrame();
+        unsigned long long frameNumber;
+        vector<TrackedBlob> objects;
+        vector<TrackedBlob> hands;
+        vector<unsigned int> deadObjectLabels;
+        vector<unsigned int> deadHandLabels;
+        //Only filled when DetectionSettings::keepMasks is set, at the detector's resolution
+        cv::Mat objectsMask;
+        cv::Mat handsMask;
+        //Objects were found on this frame, or are the last ones found. Shed:
+        //a refresh was due but didn't fit in the frame budget.
+        bool bObjectsRefreshed;
+        bool bObjectsShed;
+        //Segmentation and contours, with OFX_KINECT_OBJECTS_STATS
+        StageTimes times;
+    };
+
+    // Segmentation and contour finding for one sensor. Holds the contour
+    // finders, so their trackers keep labels stable between frames. Blobs
+    // are in full resolution kinect pixels whatever the decimation.
+    class DetectionPipeline{
+    public:
+        DetectionPipeline();
+        void process(const unsigned short* depth, const DepthSegmenter& segmenter, const DetectionSettings& settings, TrackingFrame& frame);
+
+    private:
+        void switchPath(bool singlePassLabeling);
+        void traceBlobs(const unsigned short* depth, const DepthSegmenter& segmenter, const DetectionSettings& settings, TrackingFrame& frame);
+        bool isObjectsRefreshForced(const DepthSegmenter& segmenter, const DetectionSettings& settings, const cv::Mat& objectsInput);
+        bool isObjectsRefreshDue(const DetectionSettings& settings, const cv::Mat& objectsInput, const cv::Mat& handsInput);
+        void findBlobs(ofxCv::ContourFinder& finder, cv::Mat& mask, int step, ofVec2f blobSize, const unsigned short* depth, const DepthSegmenter& segmenter, vector<TrackedBlob>& blobs);
+        void collectBlobs(ofxCv::ContourFinder& finder, const cv::Mat& mask, int step, const unsigned short* depth, const DepthSegmenter& segmenter, vector<TrackedBlob>& blobs);
+        void labelBlobs(const unsigned short* depth, const DepthSegmenter& segmenter, const DetectionSettings& settings, TrackingFrame& frame);
+        void trackBlobs(ofxCv::RectTracker& tracker, const vector<LabeledBlob>& labeled, int step, ofVec2f blobSize, const unsigned short* depth, const DepthSegmenter& segmenter, vector<TrackedBlob>& blobs);
+
+        cv::Mat objectsMask;
+        cv::Mat handsMask;
+        //The mask of the detector with the larger step, sampled from the other
+        cv::Mat decimatedMask;
+
+        IncrementalSegmenter incremental;
+        //The objects mask changed since the objects were last found
+        bool bObjectsMaskChanged;
+
+        //Last hands found, and what with, when segmenting incrementally
+        vector<TrackedBlob> hands;
+        DetectionSettings handsSettings;
+        bool bHandsFound;
+        //Labels found last time, and lost ones not dead yet
+        vector<unsigned int> handsFound, handsPending;
+        vector<unsigned int> objectsFound, objectsPending;
+
+        //Last objects found, and what they were found with
+        vector<TrackedBlob> objects;
+        //DepthSegmenter::getVersion(), 0 if none
+        unsigned long long objectsSegmenterVersion;
+        DetectionSettings objectsSettings;
+        cv::Mat objectsReference;
+        int framesSinceObjects;
+        //Smoothed time of finding the objects (microseconds), and refreshes
+        //shed in a row since the last one
+        float objectsCost;
+        int objectsShed;
+        ofxCv::ContourFinder objectsFinder;
+        ofxCv::ContourFinder handsFinder;
+
+        //Path of the last frame, labels it gave and not dead yet, and those of
+        //the other path to report dead with the next frame
+        bool bSinglePassLabeling;
+        vector<unsigned int> liveObjects, liveHands;
+        vector<unsigned int> retiredObjects, retiredHands;
+
+        //Single pass labeling, with trackers of their own
+        BlobLabeler labeler;
+        ofxCv::RectTracker objectsTracker;
+        ofxCv::RectTracker handsTracker;
+        vector<cv::Rect> trackedRects;
+        vector<int> trackedBlobs;
+    };
+
+    // Runs a DetectionPipeline on its own thread: takes the latest depth frame
+    // from one triple buffer and publishes tracking results to another, so
+    // neither the capture/render thread nor the tracking wait on each other.
+    class PipelineThread : public ofThread{
+    public:
+        PipelineThread();
+        void setup(DetectionPipeline* pipeline, TripleBuffer<DepthFrame>* depthFrames, TripleBuffer<TrackingFrame>* trackingFrames);
+        void start();
+        void stop();
+
+        //Call after publishing a depth frame
+        void notifyFrame();
+
+    private:
+        void threadedFunction();
+
+        DetectionPipeline* pipeline_;
+        TripleBuffer<DepthFrame>* depthFrames_;
+        TripleBuffer<TrackingFrame>* trackingFrames_;
+
+        //Dead labels of the last published frame, in case it gets dropped
+        vector<unsigned int> carriedObjectLabels;
+        vector<unsigned int> carriedHandLabels;
+
+        std::mutex wakeMutex;
+        std::condition_variable wakeCondition;
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,255 @@
+//
+//  ofxKinectObjectsPlaneFitter.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsPlaneFitter.h"
+#include <thread>
+
+namespace ofxKinectObjects {
+
+    //Probability of having drawn three inliers at least once when stopping early
+    static const float ransacConfidence = 0.999;
+
+    //Towards the sensor, which is at the origin
+    static ofVec3f facingSensor(ofVec3f n, ofVec3f v0){
+        return n.dot(v0) > 0 ? -n : n;
+    }
+
+    // Eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix: that
+    // eigenvalue in closed form, and then the largest cross product of two
+    // rows of a - eigenvalue * I, which are both orthogonal to the eigenvector
+    static ofVec3f smallestEigenvector(const double a[3][3]){
+        double p1 = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        double q = (a[0][0] + a[1][1] + a[2][2]) / 3;
+        double p2 = (a[0][0] - q) * (a[0][0] - q) + (a[1][1] - q) * (a[1][1] - q) + (a[2][2] - q) * (a[2][2] - q) + 2 * p1;
+        double p = sqrt(p2 / 6);
+        double eigenvalue = q;
+        if (p > 0) {
+            double b[3][3];
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    b[i][j] = (a[i][j] - (i == j ? q : 0)) / p;
+                }
+            }
+            double r = (b[0][0] * (b[1][1] * b[2][2] - b[1][2] * b[2][1])
+                        - b[0][1] * (b[1][0] * b[2][2] - b[1][2] * b[2][0])
+                        + b[0][2] * (b[1][0] * b[2][1] - b[1][1] * b[2][0])) / 2;
+            double phi = acos(ofClamp(r, -1, 1)) / 3;
+            eigenvalue = q + 2 * p * cos(phi + 2 * PI / 3);
+        }
+
+        ofVec3f rows[3];
+        for (int i = 0; i < 3; i++) {
+            rows[i].set(a[i][0] - (i == 0 ? eigenvalue : 0), a[i][1] - (i == 1 ? eigenvalue : 0), a[i][2] - (i == 2 ? eigenvalue : 0));
+        }
+        ofVec3f best;
+        for (int i = 0; i < 3; i++) {
+            ofVec3f cross = rows[i].getCrossed(rows[(i + 1) % 3]);
+            if (cross.lengthSquared() > best.lengthSquared()) {
+                best = cross;
+            }
+        }
+        return best.getNormalized();
+    }
+
+    PlaneFit::PlaneFit(){
+        inlierRatio = 0;
+        rmsError = 0;
+        bValid = false;
+    }
+
+    /***
+     PLANE FITTER
+     **___________________________________*/
+
+    PlaneFitter::PlaneFitter(){
+        step_ = 4;
+        inlierDistance_ = 10;
+        iterations_ = 500;
+        threads_ = 0;
+    }
+
+    void PlaneFitter::setSampleStep(int step){
+        step_ = MAX(step, 1);
+    }
+
+    void PlaneFitter::setInlierDistance(float distance){
+        inlierDistance_ = MAX(distance, 1.f);
+    }
+
+    void PlaneFitter::setIterations(int iterations){
+        iterations_ = MAX(iterations, 1);
+    }
+
+    void PlaneFitter::setThreads(int threads){
+        threads_ = MAX(threads, 0);
+    }
+
+    //--------------------------------------------------------------
+    PlaneFit PlaneFitter::fit(const unsigned short* depth, const DepthSegmenter& segmenter) const{
+        PlaneFit plane;
+        vector<ofVec3f> points;
+        samplePoints(depth, segmenter, points);
+        if (points.size() < 3) {
+            ofLogError("PlaneFitter") << "fit(): no depth";
+            return plane;
+        }
+
+        // each thread searches its share of the iterations with its own seed
+        int threads = threads_ > 0 ? threads_ : MAX(int(std::thread::hardware_concurrency()), 1);
+        threads = MIN(threads, iterations_);
+        vector<ofVec3f> v0s(threads), normals(threads);
+        vector<int> inliers(threads, 0);
+        vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) {
+            int iterations = iterations_ / threads;
+            workers.push_back(std::thread(&PlaneFitter::searchPlanes, this, std::cref(points), iterations, t + 1, std::ref(v0s[t]), std::ref(normals[t]), std::ref(inliers[t])));
+        }
+        searchPlanes(points, iterations_ - (threads - 1) * (iterations_ / threads), 1, v0s[0], normals[0], inliers[0]);
+        for (int t = 0; t < workers.size(); t++) {
+            workers[t].join();
+        }
+
+        int best = max_element(inliers.begin(), inliers.end()) - inliers.begin();
+        if (inliers[best] < 3) {
+            ofLogError("PlaneFitter") << "fit(): no plane";
+            return plane;
+        }
+        plane.v0 = v0s[best];
+        plane.n = facingSensor(normals[best], v0s[best]);
+        if (!refine(points, plane)) {
+            //The RANSAC plane still stands, just without least squares
+            ofLogWarning("PlaneFitter") << "fit(): least squares refinement failed";
+            plane.rmsError = rmsDistance(points, plane.v0, plane.n);
+        }
+        plane.inlierRatio = countInliers(points, plane.v0, plane.n) / float(points.size());
+        plane.bValid = true;
+        return plane;
+    }
+
+    float PlaneFitter::verify(const unsigned short* depth, const DepthSegmenter& segmenter, const PlaneFit& plane) const{
+        vector<ofVec3f> points;
+        samplePoints(depth, segmenter, points);
+        if (points.empty() || !plane.bValid) {
+            return 0;
+        }
+        return countInliers(points, plane.v0, plane.n) / float(points.size());
+    }
+
+    //--------------------------------------------------------------
+    void PlaneFitter::samplePoints(const unsigned short* depth, const DepthSegmenter& segmenter, vector<ofVec3f>& points) const{
+        int width = segmenter.getWidth(), height = segmenter.getHeight();
+        points.clear();
+        points.reserve((width / step_ + 1) * (height / step_ + 1));
+        for (int j = step_ / 2; j < height; j += step_) {
+            for (int i = step_ / 2; i < width; i += step_) {
+                if (depth[j * width + i] != 0) {
+                    points.push_back(segmenter.getWorldCoordinateAt(depth, i, j));
+                }
+            }
+        }
+    }
+
+    int PlaneFitter::countInliers(const vector<ofVec3f>& points, ofVec3f v0, ofVec3f n) const{
+        float offset = n.dot(v0);
+        int inliers = 0;
+        for (int k = 0; k < points.size(); k++) {
+            inliers += fabsf(n.dot(points[k]) - offset) <= inlierDistance_;
+        }
+        return inliers;
+    }
+
+    // Planes through three random points. Stops when, with the best inlier
+    // ratio so far, missing the plane that many times is unlikely enough.
+    void PlaneFitter::searchPlanes(const vector<ofVec3f>& points, int iterations, unsigned int seed, ofVec3f& v0, ofVec3f& n, int& inliers) const{
+        unsigned int random = seed * 2654435761u;
+        int size = points.size();
+        inliers = 0;
+        for (int k = 0; k < iterations; k++) {
+            const ofVec3f* sample[3];
+            for (int s = 0; s < 3; s++) {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+                sample[s] = &points[random % size];
+            }
+            ofVec3f normal = (*sample[1] - *sample[0]).getCrossed(*sample[2] - *sample[0]);
+            if (normal.lengthSquared() < 1e-6f) {
+                continue;
+            }
+            normal.normalize();
+            int count = countInliers(points, *sample[0], normal);
+            if (count > inliers) {
+                inliers = count;
+                v0 = *sample[0];
+                n = normal;
+                float ratio = count / float(size);
+                if (log(1 - ransacConfidence) / log(1 - ratio * ratio * ratio + 1e-9f) < k + 1) {
+                    break;
+                }
+            }
+        }
+    }
+
+    //Least squares plane of the inliers: through their mean, normal to their least spread
+    bool PlaneFitter::refine(const vector<ofVec3f>& points, PlaneFit& plane) const{
+        float offset = plane.n.dot(plane.v0);
+        double mean[3] = {0, 0, 0};
+        int count = 0;
+        for (int k = 0; k < points.size(); k++) {
+            if (fabsf(plane.n.dot(points[k]) - offset) <= inlierDistance_) {
+                mean[0] += points[k].x;
+                mean[1] += points[k].y;
+                mean[2] += points[k].z;
+                count++;
+            }
+        }
+        if (count < 3) {
+            return false;
+        }
+        for (int i = 0; i < 3; i++) {
+            mean[i] /= count;
+        }
+        double covariance[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+        for (int k = 0; k < points.size(); k++) {
+            if (fabsf(plane.n.dot(points[k]) - offset) > inlierDistance_) {
+                continue;
+            }
+            double d[3] = {points[k].x - mean[0], points[k].y - mean[1], points[k].z - mean[2]};
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    covariance[i][j] += d[i] * d[j];
+                }
+            }
+        }
+        ofVec3f v0(mean[0], mean[1], mean[2]);
+        ofVec3f n = smallestEigenvector(covariance);
+        if (n.lengthSquared() == 0) {
+            return false;
+        }
+        plane.v0 = v0;
+        plane.n = facingSensor(n, v0);
+        plane.rmsError = rmsDistance(points, plane.v0, plane.n);
+        return true;
+    }
+
+    //Of the inliers
+    float PlaneFitter::rmsDistance(const vector<ofVec3f>& points, ofVec3f v0, ofVec3f n) const{
+        double squares = 0;
+        float offset = n.dot(v0);
+        int count = 0;
+        for (int k = 0; k < points.size(); k++) {
+            float distance = n.dot(points[k]) - offset;
+            if (fabsf(distance) <= inlierDistance_) {
+                squares += distance * distance;
+                count++;
+            }
+        }
+        return count > 0 ? sqrt(squares / count) : 0;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,61 @@
+//
+//  ofxKinectObjectsPlaneFitter.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsSegmenter.h"
+
+namespace ofxKinectObjects {
+
+    //A plane of the depth frame, in the sensor's world coordinates (mm)
+    struct PlaneFit{
+        PlaneFit();
+        ofVec3f v0;
+        //Unit normal, towards the sensor
+        ofVec3f n;
+        //Of the sampled pixels with depth, those within the inlier distance
+        float inlierRatio;
+        //Root mean square distance of the inliers to the plane (mm)
+        float rmsError;
+        bool bValid;
+    };
+
+    // Finds the table without anyone clicking on it: RANSAC over a grid of
+    // pixels of one depth frame, the iterations split over threads, and then
+    // a least squares plane through the inliers of the best hypothesis. The
+    // table only has to be the largest plane in view; objects and hands on
+    // it are outliers.
+    class PlaneFitter{
+    public:
+        PlaneFitter();
+        //Every step-th pixel of every step-th row
+        void setSampleStep(int step);
+        //Distance (mm) under which a point is on the plane
+        void setInlierDistance(float distance);
+        //At most, stops before when the best plane is certain enough
+        void setIterations(int iterations);
+        //0, one per core
+        void setThreads(int threads);
+
+        PlaneFit fit(const unsigned short* depth, const DepthSegmenter& segmenter) const;
+        //Inlier ratio of a known plane in a new frame
+        float verify(const unsigned short* depth, const DepthSegmenter& segmenter, const PlaneFit& plane) const;
+
+    private:
+        void samplePoints(const unsigned short* depth, const DepthSegmenter& segmenter, vector<ofVec3f>& points) const;
+        int countInliers(const vector<ofVec3f>& points, ofVec3f v0, ofVec3f n) const;
+        void searchPlanes(const vector<ofVec3f>& points, int iterations, unsigned int seed, ofVec3f& v0, ofVec3f& n, int& inliers) const;
+        bool refine(const vector<ofVec3f>& points, PlaneFit& plane) const;
+        float rmsDistance(const vector<ofVec3f>& points, ofVec3f v0, ofVec3f n) const;
+
+        int step_;
+        float inlierDistance_;
+        int iterations_;
+        int threads_;
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,175 @@
+//
+//  ofxKinectObjectsPublisher.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsPublisher.h"
+#ifndef TARGET_WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ofxKinectObjects {
+
+    static void fillBlob(const HandState& state, SharedBlob& blob){
+        blob.label = state.label;
+        blob.sensor = state.sensor;
+        blob.category = 0;
+        blob.touchedBy = sharedResultsNoLabel;
+        blob.centroid[0] = state.worldCentroid.x;
+        blob.centroid[1] = state.worldCentroid.y;
+        blob.centroid[2] = state.worldCentroid.z;
+        for (int i = 0; i < 4; i++) {
+            ofVec3f corner = i < state.worldQuad.size() ? state.worldQuad[i] : ofVec3f();
+            blob.quad[i][0] = corner.x;
+            blob.quad[i][1] = corner.y;
+            blob.quad[i][2] = corner.z;
+        }
+        blob.area = state.area;
+    }
+
+    ResultsPublisher::ResultsPublisher(){
+        header_ = NULL;
+        size_ = 0;
+        published_ = 0;
+        bTruncatedWarned_ = false;
+    }
+
+    ResultsPublisher::~ResultsPublisher(){
+        close();
+    }
+
+    bool ResultsPublisher::setup(string name, int maxObjects, int maxHands, int slots){
+        close();
+    #ifdef TARGET_WIN32
+        ofLogError("ResultsPublisher") << "setup(): shared memory results need POSIX shared memory";
+        return false;
+    #else
+        if (name.empty() || name[0] != '/' || maxObjects < 0 || maxHands < 0 || slots < 2) {
+            ofLogError("ResultsPublisher") << "setup(): invalid name " << name << " or sizes";
+            return false;
+        }
+
+        //Readers still mapping a segment a crashed publisher left behind move on to the new one
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(SharedHeader)) {
+                void* mapped = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (mapped != MAP_FAILED) {
+                    SharedHeader* stale = (SharedHeader*)mapped;
+                    if (stale->magic == sharedResultsMagic) {
+                        stale->closed.store(1, std::memory_order_release);
+                    }
+                    munmap(mapped, info.st_size);
+                }
+            }
+            ::close(fd);
+            shm_unlink(name.c_str());
+        }
+
+        size_t size = getSharedResultsSize(slots, maxObjects, maxHands);
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            ofLogError("ResultsPublisher") << "setup(): couldn't create " << name << ": " << strerror(errno);
+            return false;
+        }
+        void* mapped = MAP_FAILED;
+        if (ftruncate(fd, size) == 0) {
+            mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            ofLogError("ResultsPublisher") << "setup(): couldn't map " << size << " bytes of " << name << ": " << strerror(errno);
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        //ftruncate() zeroes it: no frame published, every slot sequence 0
+        name_ = name;
+        header_ = (SharedHeader*)mapped;
+        size_ = size;
+        published_ = 0;
+        bTruncatedWarned_ = false;
+        header_->version = sharedResultsVersion;
+        header_->slotCount = slots;
+        header_->slotSize = getSharedSlotSize(maxObjects, maxHands);
+        header_->maxObjects = maxObjects;
+        header_->maxHands = maxHands;
+        header_->closed.store(0, std::memory_order_relaxed);
+        header_->published.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = sharedResultsMagic;
+        return true;
+    #endif
+    }
+
+    SharedSlot* ResultsPublisher::getSlot(uint64_t frame){
+        return (SharedSlot*)((char*)header_ + getSharedSlotOffset(*header_, frame));
+    }
+
+    //--------------------------------------------------------------
+    void ResultsPublisher::publish(const FrameSnapshot& snapshot){
+        if (!header_) {
+            return;
+        }
+        uint32_t objects = MIN(snapshot.objects.size(), header_->maxObjects);
+        uint32_t hands = MIN(snapshot.hands.size(), header_->maxHands);
+        if ((objects < snapshot.objects.size() || hands < snapshot.hands.size()) && !bTruncatedWarned_) {
+            ofLogWarning("ResultsPublisher") << "publish(): " << snapshot.objects.size() << " objects and " << snapshot.hands.size() << " hands, publishing " << objects << " and " << hands;
+            bTruncatedWarned_ = true;
+        }
+
+        uint64_t frame = published_ + 1;
+        SharedSlot* slot = getSlot(frame);
+        slot->sequence.store(2 * frame - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->frameNumber = snapshot.frameNumber;
+        slot->objectCount = objects;
+        slot->handCount = hands;
+        SharedBlob* blobs = (SharedBlob*)(slot + 1);
+        for (int i = 0; i < objects; i++) {
+            const ObjectState& object = snapshot.objects[i];
+            fillBlob(object, blobs[i]);
+            blobs[i].category = object.category;
+            blobs[i].touchedBy = object.touchedBy;
+        }
+        for (int i = 0; i < hands; i++) {
+            fillBlob(snapshot.hands[i], blobs[header_->maxObjects + i]);
+        }
+        slot->publishedMicros = sharedResultsMicros();
+
+        slot->sequence.store(2 * frame, std::memory_order_release);
+        header_->published.store(frame, std::memory_order_release);
+        published_ = frame;
+    }
+
+    void ResultsPublisher::close(){
+    #ifndef TARGET_WIN32
+        if (header_) {
+            header_->closed.store(1, std::memory_order_release);
+            munmap(header_, size_);
+            shm_unlink(name_.c_str());
+        }
+    #endif
+        header_ = NULL;
+        size_ = 0;
+        name_.clear();
+    }
+
+    bool ResultsPublisher::isOpen() const{
+        return header_ != NULL;
+    }
+
+    unsigned long long ResultsPublisher::getPublishedCount() const{
+        return published_;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,44 @@
+//
+//  ofxKinectObjectsPublisher.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxKinectObjectsSnapshot.h"
+#include "ofxKinectObjectsSharedResults.h"
+
+namespace ofxKinectObjects {
+
+    // Writes every tracking result to a ring of slots in POSIX shared
+    // memory, for SharedResultsReader in other processes. Single producer:
+    // one publisher per name.
+    class ResultsPublisher{
+    public:
+        ResultsPublisher();
+        ~ResultsPublisher();
+        //Objects and hands beyond the maximums are not published
+        bool setup(string name = sharedResultsDefaultName, int maxObjects = 64, int maxHands = 16, int slots = 8);
+        void publish(const FrameSnapshot& snapshot);
+        //Tells readers and removes the name
+        void close();
+        bool isOpen() const;
+        unsigned long long getPublishedCount() const;
+
+    private:
+        SharedSlot* getSlot(uint64_t frame);
+
+        string name_;
+        SharedHeader* header_;
+        size_t size_;
+        uint64_t published_;
+        bool bTruncatedWarned_;
+
+        ResultsPublisher(const ResultsPublisher&);
+        ResultsPublisher& operator=(const ResultsPublisher&);
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,438 @@
+//
+//  ofxKinectObjectsReplay.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsReplay.h"
+#ifndef TARGET_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ofxKinectObjects {
+
+    static const char recordingMagic[4] = {'O', 'K', 'O', 'D'};
+    static const int recordingVersion = 1;
+    //Larger than any depth sensor: a bigger side is a corrupt header
+    static const int maxRecordingSide = 8192;
+
+    struct RecordingHeader{
+        int version;
+        int width, height;
+        float zeroPlanePixelSize, zeroPlaneDistance;
+    };
+
+    struct FrameHeader{
+        unsigned int size;
+        unsigned int key;
+        double timestamp;
+    };
+
+    /***
+     CODEC
+     **___________________________________*/
+
+    static void writeVarint(unsigned int value, vector<unsigned char>& out){
+        while (value >= 0x80) {
+            out.push_back((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(value);
+    }
+
+    static bool readVarint(const unsigned char*& data, const unsigned char* end, unsigned int& value){
+        value = 0;
+        for (int shift = 0; data < end && shift < 32; shift += 7) {
+            unsigned char byte = *data++;
+            value |= (byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Encoded as 0, run length - 1. Anything else is a zigzag coded residual.
+    void encodeDepth(const unsigned short* depth, const unsigned short* previous, int n, vector<unsigned char>& encoded){
+        encoded.clear();
+        int i = 0;
+        while (i < n) {
+            int prediction = previous ? previous[i] : (i > 0 ? depth[i - 1] : 0);
+            int residual = depth[i] - prediction;
+            if (residual != 0) {
+                writeVarint((residual << 1) ^ (residual >> 31), encoded);
+                i++;
+                continue;
+            }
+            int run = 1;
+            while (i + run < n && depth[i + run] == (previous ? previous[i + run] : depth[i + run - 1])) {
+                run++;
+            }
+            encoded.push_back(0);
+            writeVarint(run - 1, encoded);
+            i += run;
+        }
+    }
+
+    bool decodeDepth(const unsigned char* data, size_t size, const unsigned short* previous, int n, unsigned short* depth){
+        const unsigned char* end = data + size;
+        int i = 0;
+        unsigned int value;
+        while (i < n) {
+            if (!readVarint(data, end, value)) {
+                return false;
+            }
+            if (value != 0) {
+                int residual = (value >> 1) ^ -int(value & 1);
+                int prediction = previous ? previous[i] : (i > 0 ? depth[i - 1] : 0);
+                depth[i++] = prediction + residual;
+                continue;
+            }
+            if (!readVarint(data, end, value) || value >= unsigned(n - i)) {
+                return false;
+            }
+            for (int run = value + 1; run > 0; run--, i++) {
+                depth[i] = previous ? previous[i] : (i > 0 ? depth[i - 1] : 0);
+            }
+        }
+        return data == end;
+    }
+
+    /***
+     RECORDER
+     **___________________________________*/
+
+    DepthRecorder::DepthRecorder(){
+        width_ = height_ = 0;
+        frames_ = 0;
+        keyFrameInterval_ = 30;
+        startTime_ = 0;
+    }
+
+    DepthRecorder::~DepthRecorder(){
+        stop();
+    }
+
+    bool DepthRecorder::start(string path, DepthSource& source){
+        stop();
+        file.open(ofToDataPath(path).c_str(), ios::binary);
+        if (!file) {
+            ofLogError("DepthRecorder") << "start(): couldn't open " << path;
+            return false;
+        }
+        path_ = path;
+        width_ = source.getWidth();
+        height_ = source.getHeight();
+        frames_ = 0;
+
+        RecordingHeader header;
+        header.version = recordingVersion;
+        header.width = width_;
+        header.height = height_;
+        header.zeroPlanePixelSize = source.getZeroPlanePixelSize();
+        header.zeroPlaneDistance = source.getZeroPlaneDistance();
+        file.write(recordingMagic, sizeof(recordingMagic));
+        file.write((const char*)&header, sizeof(header));
+        return file.good();
+    }
+
+    void DepthRecorder::addFrame(const unsigned short* depth, double timestamp){
+        if (!isRecording()) {
+            return;
+        }
+        if (frames_ == 0) {
+            startTime_ = timestamp;
+        }
+
+        FrameHeader header;
+        header.key = frames_ % keyFrameInterval_ == 0;
+        header.timestamp = timestamp - startTime_;
+        encodeDepth(depth, header.key ? NULL : &previous[0], width_ * height_, encoded);
+        header.size = encoded.size();
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)&encoded[0], encoded.size());
+        if (!file) {
+            ofLogError("DepthRecorder") << "addFrame(): couldn't write " << path_;
+            stop();
+            return;
+        }
+
+        previous.assign(depth, depth + width_ * height_);
+        frames_++;
+    }
+
+    void DepthRecorder::stop(){
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+
+    bool DepthRecorder::isRecording() const{
+        return file.is_open();
+    }
+
+    int DepthRecorder::getFrameCount() const{
+        return frames_;
+    }
+
+    void DepthRecorder::setKeyFrameInterval(int frames){
+        keyFrameInterval_ = MAX(frames, 1);
+    }
+
+    /***
+     REPLAY
+     **___________________________________*/
+
+    ReplaySource::ReplaySource(string path){
+        path_ = path;
+        data_ = NULL;
+        size_ = 0;
+    #ifndef TARGET_WIN32
+        fd_ = -1;
+    #endif
+        width_ = height_ = 0;
+        zeroPlanePixelSize_ = zeroPlaneDistance_ = 0;
+        current_ = -1;
+        bFrameNew_ = bRealTime_ = bLoop_ = false;
+        startTime_ = 0;
+        bDepthImageDirty = false;
+    }
+
+    ReplaySource::~ReplaySource(){
+        close();
+    }
+
+    bool ReplaySource::setup(){
+        close();
+        string filePath = ofToDataPath(path_);
+    #ifdef TARGET_WIN32
+        ifstream file(filePath.c_str(), ios::binary);
+        buffer_.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        data_ = buffer_.empty() ? NULL : &buffer_[0];
+        size_ = buffer_.size();
+    #else
+        fd_ = open(filePath.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd_ >= 0 && fstat(fd_, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = (const unsigned char*)mapped;
+                size_ = info.st_size;
+                madvise(mapped, size_, MADV_SEQUENTIAL);
+            }
+        }
+    #endif
+
+        RecordingHeader header;
+        size_t offset = sizeof(recordingMagic) + sizeof(header);
+        if (!data_ || size_ < offset || memcmp(data_, recordingMagic, sizeof(recordingMagic)) != 0) {
+            ofLogError("ReplaySource") << "setup(): " << path_ << " is not a depth recording";
+            close();
+            return false;
+        }
+        memcpy(&header, data_ + sizeof(recordingMagic), sizeof(header));
+        if (header.version != recordingVersion) {
+            ofLogError("ReplaySource") << "setup(): " << path_ << " has version " << header.version;
+            close();
+            return false;
+        }
+        if (header.width <= 0 || header.height <= 0 || header.width > maxRecordingSide || header.height > maxRecordingSide) {
+            ofLogError("ReplaySource") << "setup(): " << path_ << " has invalid size " << header.width << "x" << header.height;
+            close();
+            return false;
+        }
+
+        //Index of the frames. A frame cut short by a crash ends the recording.
+        frames_.clear();
+        FrameHeader frame;
+        while (offset + sizeof(frame) <= size_) {
+            memcpy(&frame, data_ + offset, sizeof(frame));
+            if (offset + sizeof(frame) + frame.size > size_) {
+                break;
+            }
+            frames_.push_back(offset);
+            offset += sizeof(frame) + frame.size;
+        }
+        if (frames_.empty()) {
+            ofLogError("ReplaySource") << "setup(): " << path_ << " has no frames";
+            close();
+            return false;
+        }
+
+        //Only a recording that plays replaces the size of the last one
+        width_ = header.width;
+        height_ = header.height;
+        zeroPlanePixelSize_ = header.zeroPlanePixelSize;
+        zeroPlaneDistance_ = header.zeroPlaneDistance;
+        depth_.assign(width_ * height_, 0);
+        current_ = -1;
+        startTime_ = ofGetElapsedTimef();
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    void ReplaySource::update(){
+        bFrameNew_ = false;
+        if (frames_.empty()) {
+            return;
+        }
+        if (isFinished()) {
+            if (!bLoop_) {
+                return;
+            }
+            current_ = -1;
+            startTime_ = ofGetElapsedTimef();
+        }
+
+        //Real time: every frame due since the last update. Delta frames
+        //need their predecessors decoded, so none is skipped.
+        int last = current_ + 1;
+        if (bRealTime_) {
+            double elapsed = ofGetElapsedTimef() - startTime_;
+            while (last + 1 < frames_.size() && getFrameTimestamp(last + 1) <= elapsed) {
+                last++;
+            }
+            if (getFrameTimestamp(last) > elapsed) {
+                return;
+            }
+        }
+        while (current_ < last) {
+            int frame = current_ + 1;
+            if (!decodeFrame(frame)) {
+                // the frames up to the next key frame need this one: resume there
+                int key = findKeyFrame(frame + 1);
+                if (key < 0) {
+                    ofLogError("ReplaySource") << "update(): frame " << frame << " of " << path_ << " is corrupt, and no key frame follows";
+                    frames_.resize(frame);
+                    return;
+                }
+                ofLogError("ReplaySource") << "update(): frame " << frame << " of " << path_ << " is corrupt, resuming at frame " << key;
+                current_ = key - 1;
+                last = MAX(last, key);
+                continue;
+            }
+            current_++;
+            bFrameNew_ = true;
+            bDepthImageDirty = true;
+        }
+    }
+
+    bool ReplaySource::decodeFrame(int frame){
+        FrameHeader header;
+        memcpy(&header, data_ + frames_[frame], sizeof(header));
+        if (!header.key && current_ != frame - 1) {
+            return false;
+        }
+        //Into a scratch buffer, so a corrupt frame leaves the last good one
+        decoded_.resize(depth_.size());
+        if (!decodeDepth(data_ + frames_[frame] + sizeof(header), header.size, header.key ? NULL : &depth_[0], depth_.size(), &decoded_[0])) {
+            return false;
+        }
+        depth_.swap(decoded_);
+        return true;
+    }
+
+    //-1 if there is none from frame on
+    int ReplaySource::findKeyFrame(int frame){
+        FrameHeader header;
+        for (; frame < frames_.size(); frame++) {
+            memcpy(&header, data_ + frames_[frame], sizeof(header));
+            if (header.key) {
+                return frame;
+            }
+        }
+        return -1;
+    }
+
+    double ReplaySource::getFrameTimestamp(int frame){
+        FrameHeader header;
+        memcpy(&header, data_ + frames_[frame], sizeof(header));
+        return header.timestamp;
+    }
+
+    //--------------------------------------------------------------
+    bool ReplaySource::isFrameNew(){
+        return bFrameNew_;
+    }
+
+    const unsigned short* ReplaySource::getDepthPixels(){
+        return &depth_[0];
+    }
+
+    int ReplaySource::getWidth(){
+        return width_;
+    }
+
+    int ReplaySource::getHeight(){
+        return height_;
+    }
+
+    double ReplaySource::getTimestamp(){
+        return current_ >= 0 ? getFrameTimestamp(current_) : 0;
+    }
+
+    //Same as freenect_camera_to_world()
+    ofVec3f ReplaySource::getWorldCoordinateAt(float x, float y, float z){
+        float factor = 2 * zeroPlanePixelSize_ * z / zeroPlaneDistance_;
+        return ofVec3f((int(x) - width_ / 2) * factor, (int(y) - height_ / 2) * factor, z);
+    }
+
+    float ReplaySource::getZeroPlanePixelSize(){
+        return zeroPlanePixelSize_;
+    }
+
+    float ReplaySource::getZeroPlaneDistance(){
+        return zeroPlaneDistance_;
+    }
+
+    void ReplaySource::drawDepth(float x, float y, float w, float h){
+        if (!depth_.empty()) {
+            drawDepthImage(depthImage, bDepthImageDirty, x, y, w, h);
+        }
+    }
+
+    void ReplaySource::close(){
+    #ifdef TARGET_WIN32
+        buffer_.clear();
+    #else
+        if (data_) {
+            munmap((void*)data_, size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    #endif
+        data_ = NULL;
+        size_ = 0;
+        frames_.clear();
+    }
+
+    //--------------------------------------------------------------
+    void ReplaySource::setRealTime(bool realTime){
+        bRealTime_ = realTime;
+        startTime_ = ofGetElapsedTimef() - getTimestamp();
+    }
+
+    void ReplaySource::setLoop(bool loop){
+        bLoop_ = loop;
+    }
+
+    bool ReplaySource::isFinished(){
+        return current_ + 1 >= frames_.size();
+    }
+
+    int ReplaySource::getFrameCount(){
+        return frames_.size();
+    }
+
+    int ReplaySource::getCurrentFrame(){
+        return current_;
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,103 @@
+//
+//  ofxKinectObjectsReplay.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsDepthSource.h"
+
+namespace ofxKinectObjects {
+
+    // Lossless depth frame compression. Every value is predicted from the
+    // previous frame, or from its left neighbour when previous is NULL (key
+    // frames). Runs of exact predictions are run-length coded, the rest is
+    // stored as zigzag varints: one byte for the few mm of kinect noise.
+    void encodeDepth(const unsigned short* depth, const unsigned short* previous, int n, vector<unsigned char>& encoded);
+    //False if data is not n encoded values
+    bool decodeDepth(const unsigned char* data, size_t size, const unsigned short* previous, int n, unsigned short* depth);
+
+    // Writes depth frames and their timestamps to a file ReplaySource can
+    // play. The file starts with the source's size and calibration, so the
+    // replay gives the same world coordinates.
+    class DepthRecorder{
+    public:
+        DepthRecorder();
+        ~DepthRecorder();
+        bool start(string path, DepthSource& source);
+        void addFrame(const unsigned short* depth, double timestamp);
+        void stop();
+        bool isRecording() const;
+        int getFrameCount() const;
+        //A key frame every this many frames: replay resumes at the next one
+        //after a damaged frame
+        void setKeyFrameInterval(int frames);
+
+    private:
+        ofstream file;
+        string path_;
+        int width_, height_;
+        int frames_, keyFrameInterval_;
+        double startTime_;
+        vector<unsigned short> previous;
+        vector<unsigned char> encoded;
+    };
+
+    // Plays a DepthRecorder file. The file is memory mapped and frames are
+    // decoded one at a time, so long sessions don't need to fit in memory.
+    class ReplaySource : public DepthSource{
+    public:
+        ReplaySource(string path);
+        ~ReplaySource();
+        using DepthSource::getWorldCoordinateAt;
+
+        bool setup();
+        void update();
+        bool isFrameNew();
+        const unsigned short* getDepthPixels();
+        int getWidth();
+        int getHeight();
+        double getTimestamp();
+        ofVec3f getWorldCoordinateAt(float x, float y, float z);
+        float getZeroPlanePixelSize();
+        float getZeroPlaneDistance();
+        void drawDepth(float x, float y, float w, float h);
+        void close();
+
+        //Play at the recorded frame rate instead of a frame per update() (default)
+        void setRealTime(bool realTime);
+        void setLoop(bool loop);
+        bool isFinished();
+        int getFrameCount();
+        //Index of the current frame, -1 before the first one
+        int getCurrentFrame();
+
+    private:
+        bool decodeFrame(int frame);
+        int findKeyFrame(int frame);
+        double getFrameTimestamp(int frame);
+
+        string path_;
+        const unsigned char* data_;
+        size_t size_;
+    #ifdef TARGET_WIN32
+        vector<unsigned char> buffer_;
+    #else
+        int fd_;
+    #endif
+        vector<size_t> frames_;
+        int width_, height_;
+        float zeroPlanePixelSize_, zeroPlaneDistance_;
+
+        vector<unsigned short> depth_, decoded_;
+        int current_;
+        bool bFrameNew_, bRealTime_, bLoop_;
+        double startTime_;
+
+        ofImage depthImage;
+        bool bDepthImageDirty;
+    };
+
+} //namespace ofxKinectObjects
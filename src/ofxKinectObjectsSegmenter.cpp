@@ -0,0 +1,298 @@
+//
+//  ofxKinectObjectsSegmenter.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsSegmenter.h"
+#include <atomic>
+#include <cfloat>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OFX_KINECT_OBJECTS_SSE2
+#endif
+
+namespace ofxKinectObjects {
+
+    //Classifies one row: band = {floorMin, floorMax, handsMin, handsMax}
+    static void classifyRow(const unsigned short* depth, const float* coefficients, const float* offsets, int n, const float* band, unsigned char* objects, unsigned char* hands){
+        int i = 0;
+#if defined(__AVX2__)
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        const __m256 floorMin = _mm256_set1_ps(band[0]), floorMax = _mm256_set1_ps(band[1]);
+        const __m256 handsMin = _mm256_set1_ps(band[2]), handsMax = _mm256_set1_ps(band[3]);
+        for (; i + 16 <= n; i += 16) {
+            __m256 floor[2], hand[2];
+            for (int k = 0; k < 2; k++) {
+                __m128i d = _mm_loadu_si128((const __m128i*)(depth + i + 8 * k));
+                __m256 z = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(d));
+                __m256 distance = _mm256_and_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(coefficients + i + 8 * k), z), _mm256_loadu_ps(offsets + i + 8 * k)), absMask);
+                floor[k] = _mm256_and_ps(_mm256_cmp_ps(distance, floorMin, _CMP_GE_OQ), _mm256_cmp_ps(distance, floorMax, _CMP_LE_OQ));
+                hand[k] = _mm256_andnot_ps(floor[k], _mm256_and_ps(_mm256_cmp_ps(distance, handsMin, _CMP_GE_OQ), _mm256_cmp_ps(distance, handsMax, _CMP_LE_OQ)));
+            }
+            //packs works per 128-bit lane, permute restores pixel order before the final pack
+            __m256i floor16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_castps_si256(floor[0]), _mm256_castps_si256(floor[1])), _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i hand16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_castps_si256(hand[0]), _mm256_castps_si256(hand[1])), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)(objects + i), _mm_packs_epi16(_mm256_castsi256_si128(floor16), _mm256_extracti128_si256(floor16, 1)));
+            _mm_storeu_si128((__m128i*)(hands + i), _mm_packs_epi16(_mm256_castsi256_si128(hand16), _mm256_extracti128_si256(hand16, 1)));
+        }
+#elif defined(OFX_KINECT_OBJECTS_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 floorMin = _mm_set1_ps(band[0]), floorMax = _mm_set1_ps(band[1]);
+        const __m128 handsMin = _mm_set1_ps(band[2]), handsMax = _mm_set1_ps(band[3]);
+        for (; i + 16 <= n; i += 16) {
+            __m128i d[2] = {_mm_loadu_si128((const __m128i*)(depth + i)), _mm_loadu_si128((const __m128i*)(depth + i + 8))};
+            __m128i floor[4], hand[4];
+            for (int k = 0; k < 4; k++) {
+                __m128i d32 = (k % 2 == 0) ? _mm_unpacklo_epi16(d[k / 2], zero) : _mm_unpackhi_epi16(d[k / 2], zero);
+                __m128 distance = _mm_and_ps(_mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(coefficients + i + 4 * k), _mm_cvtepi32_ps(d32)), _mm_loadu_ps(offsets + i + 4 * k)), absMask);
+                __m128 inFloor = _mm_and_ps(_mm_cmpge_ps(distance, floorMin), _mm_cmple_ps(distance, floorMax));
+                __m128 inHands = _mm_andnot_ps(inFloor, _mm_and_ps(_mm_cmpge_ps(distance, handsMin), _mm_cmple_ps(distance, handsMax)));
+                floor[k] = _mm_castps_si128(inFloor);
+                hand[k] = _mm_castps_si128(inHands);
+            }
+            //all-ones lanes saturate to 0xFF bytes
+            _mm_storeu_si128((__m128i*)(objects + i), _mm_packs_epi16(_mm_packs_epi32(floor[0], floor[1]), _mm_packs_epi32(floor[2], floor[3])));
+            _mm_storeu_si128((__m128i*)(hands + i), _mm_packs_epi16(_mm_packs_epi32(hand[0], hand[1]), _mm_packs_epi32(hand[2], hand[3])));
+        }
+#endif
+        for (; i < n; i++) {
+            float distance = fabsf(coefficients[i] * depth[i] - offsets[i]);
+            //OBJECTS ON THE FLOOR
+            bool floor = distance >= band[0] && distance <= band[1];
+            //HANDS ON OBJECTS
+            bool hand = !floor && distance >= band[2] && distance <= band[3];
+            objects[i] = floor ? 255 : 0;
+            hands[i] = hand ? 255 : 0;
+        }
+    }
+
+    //Sampled pixels gathered at a time, on the stack
+    static const int gatherSize = 256;
+
+    // Every step-th pixel of a row, gathered in blocks the row kernel can take.
+    // Step is the stride at compile time, so the gather loads are constant
+    // offsets the compiler unrolls; 0 takes it from step.
+    template <int Step>
+    static void classifySampledRow(const unsigned short* depth, const float* coefficients, const float* offsets, int step, int n, const float* band, unsigned char* objects, unsigned char* hands){
+        const int stride = Step > 0 ? Step : step;
+        unsigned short depthBlock[gatherSize];
+        float coefficientBlock[gatherSize], offsetBlock[gatherSize];
+        for (int start = 0; start < n; start += gatherSize) {
+            int count = MIN(gatherSize, n - start);
+            const unsigned short* depthRow = depth + start * stride;
+            const float* coefficientRow = coefficients + start * stride;
+            const float* offsetRow = offsets + start * stride;
+            for (int i = 0; i < count; i++) {
+                depthBlock[i] = depthRow[i * stride];
+                coefficientBlock[i] = coefficientRow[i * stride];
+                offsetBlock[i] = offsetRow[i * stride];
+            }
+            classifyRow(depthBlock, coefficientBlock, offsetBlock, count, band, objects + start, hands + start);
+        }
+    }
+
+    //Shared by all segmenters, so no two get the same version
+    static std::atomic<unsigned long long> nextVersion(1);
+
+    DepthSegmenter::DepthSegmenter(){
+        width_ = height_ = 0;
+        bPlane_ = false;
+        planeOffset_ = 0;
+        updateVersion();
+    }
+
+    //--------------------------------------------------------------
+    void DepthSegmenter::setup(int width, int height){
+        width_ = width;
+        height_ = height;
+        bPlane_ = false;
+        planeOffset_ = 0;
+        rays_.clear();
+        planeCoefficients_.clear();
+        backgroundDepth_.clear();
+        //Uncalibrated: every pixel is at distance 0, as with a zero normal
+        coefficients_.assign(width * height, 0);
+        offsets_.assign(width * height, 0);
+        updateVersion();
+    }
+
+    //--------------------------------------------------------------
+    void DepthSegmenter::setRays(DepthSource& source){
+        //World coordinates are linear in depth, so the point at depth 1 is the ray
+        rays_.resize(width_ * height_);
+        for (int j = 0; j < height_; j++) {
+            for (int i = 0; i < width_; i++) {
+                rays_[j * width_ + i] = source.getWorldCoordinateAt(float(i), float(j), 1.0f);
+            }
+        }
+        updateVersion();
+    }
+
+    //--------------------------------------------------------------
+    void DepthSegmenter::setRays(const vector<ofVec3f>& rays){
+        rays_ = rays;
+        updateVersion();
+    }
+    
+    bool DepthSegmenter::hasRays() const{
+        return rays_.size() == width_ * height_ && !rays_.empty();
+    }
+
+    //--------------------------------------------------------------
+    void DepthSegmenter::setBackgroundPlane(ofVec3f v0, ofVec3f n){
+        if (!hasRays()) {
+            ofLogError("DepthSegmenter") << "setBackgroundPlane(): no rays, call setRays() first";
+            return;
+        }
+        planeCoefficients_.resize(rays_.size());
+        for (int k = 0; k < rays_.size(); k++) {
+            planeCoefficients_[k] = n.dot(rays_[k]);
+        }
+        planeOffset_ = n.dot(v0);
+        bPlane_ = true;
+        updateCoefficients();
+    }
+    
+    //--------------------------------------------------------------
+    void DepthSegmenter::setBackgroundDepth(const vector<float>& depth){
+        if (depth.size() != width_ * height_) {
+            ofLogError("DepthSegmenter") << "setBackgroundDepth(): expected " << width_ << "x" << height_ << " values";
+            return;
+        }
+        backgroundDepth_ = depth;
+        updateCoefficients();
+    }
+    
+    void DepthSegmenter::clearBackgroundDepth(){
+        backgroundDepth_.clear();
+        updateCoefficients();
+    }
+    
+    //--------------------------------------------------------------
+    void DepthSegmenter::updateCoefficients(){
+        if (hasBackgroundDepth()) {
+            for (int k = 0; k < backgroundDepth_.size(); k++) {
+                if (backgroundDepth_[k] > 0) {
+                    coefficients_[k] = bPlane_ ? planeCoefficients_[k] : 1;
+                    offsets_[k] = coefficients_[k] * backgroundDepth_[k];
+                } else {
+                    //|0 * z + FLT_MAX| is outside any band
+                    coefficients_[k] = 0;
+                    offsets_[k] = -FLT_MAX;
+                }
+            }
+        } else if (bPlane_) {
+            coefficients_ = planeCoefficients_;
+            offsets_.assign(width_ * height_, planeOffset_);
+        }
+        updateVersion();
+    }
+    
+    void DepthSegmenter::updateVersion(){
+        version_ = nextVersion++;
+    }
+    
+    unsigned long long DepthSegmenter::getVersion() const{
+        return version_;
+    }
+    
+    bool DepthSegmenter::hasBackgroundPlane() const{
+        return bPlane_;
+    }
+    
+    bool DepthSegmenter::hasBackgroundDepth() const{
+        return !backgroundDepth_.empty();
+    }
+
+    bool DepthSegmenter::isReady() const{
+        return hasBackgroundPlane() || hasBackgroundDepth();
+    }
+
+    int DepthSegmenter::getWidth() const{
+        return width_;
+    }
+
+    int DepthSegmenter::getHeight() const{
+        return height_;
+    }
+
+    //--------------------------------------------------------------
+    ofVec3f DepthSegmenter::getWorldCoordinateAt(const unsigned short* depth, int x, int y) const{
+        if (!hasRays()) {
+            return ofVec3f();
+        }
+        x = ofClamp(x, 0, width_ - 1);
+        y = ofClamp(y, 0, height_ - 1);
+        return rays_[y * width_ + x] * depth[y * width_ + x];
+    }
+
+    //--------------------------------------------------------------
+    void DepthSegmenter::segment(const unsigned short* depth, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold, int step) const{
+        int width = getMaskWidth(step), height = getMaskHeight(step);
+        objectsMask.create(height, width, CV_8UC1);
+        handsMask.create(height, width, CV_8UC1);
+        segmentRect(depth, objectsMask, handsMask, floorThreshold, handsThreshold, step, cv::Rect(0, 0, width, height));
+    }
+    
+    void DepthSegmenter::segmentRect(const unsigned short* depth, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold, int step, cv::Rect rect) const{
+        const float band[4] = {floorThreshold.x, floorThreshold.y, handsThreshold.x, handsThreshold.y};
+        
+        if (step == 1) {
+            for (int j = rect.y; j < rect.y + rect.height; j++) {
+                int row = j * width_ + rect.x;
+                classifyRow(depth + row, &coefficients_[row], &offsets_[row], rect.width, band, objectsMask.ptr<unsigned char>(j) + rect.x, handsMask.ptr<unsigned char>(j) + rect.x);
+            }
+            return;
+        }
+        
+        //The decimations ObjectTracker takes have their own instance
+        void (*classifySampled)(const unsigned short*, const float*, const float*, int, int, const float*, unsigned char*, unsigned char*) = classifySampledRow<0>;
+        if (step == 2) {
+            classifySampled = classifySampledRow<2>;
+        } else if (step == 4) {
+            classifySampled = classifySampledRow<4>;
+        }
+        for (int j = rect.y; j < rect.y + rect.height; j++) {
+            int row = j * step * width_ + rect.x * step;
+            classifySampled(depth + row, &coefficients_[row], &offsets_[row], step, rect.width, band, objectsMask.ptr<unsigned char>(j) + rect.x, handsMask.ptr<unsigned char>(j) + rect.x);
+        }
+    }
+    
+    int DepthSegmenter::getMaskWidth(int step) const{
+        return (width_ + step - 1) / step;
+    }
+    
+    int DepthSegmenter::getMaskHeight(int step) const{
+        return (height_ + step - 1) / step;
+    }
+    
+    //--------------------------------------------------------------
+    void DepthSegmenter::segmentScalar(const unsigned short* depth, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold) const{
+        objectsMask.create(height_, width_, CV_8UC1);
+        handsMask.create(height_, width_, CV_8UC1);
+        
+        for (int j = 0; j < height_; j++) {
+            const unsigned short* depthRow = depth + j * width_;
+            const float* coefficientRow = &coefficients_[j * width_];
+            const float* offsetRow = &offsets_[j * width_];
+            unsigned char* objectsRow = objectsMask.ptr<unsigned char>(j);
+            unsigned char* handsRow = handsMask.ptr<unsigned char>(j);
+            
+            for (int i = 0; i < width_; i++) {
+                float distance = fabsf(coefficientRow[i] * depthRow[i] - offsetRow[i]);
+                bool floor = distance >= floorThreshold.x && distance <= floorThreshold.y;
+                bool hand = !floor && distance >= handsThreshold.x && distance <= handsThreshold.y;
+                objectsRow[i] = floor ? 255 : 0;
+                handsRow[i] = hand ? 255 : 0;
+            }
+        }
+    }
+
+} //namespace ofxKinectObjects
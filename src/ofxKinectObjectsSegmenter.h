@@ -0,0 +1,80 @@
+//
+//  ofxKinectObjectsSegmenter.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsDepthSource.h"
+#include "ofxCv.h"
+
+namespace ofxKinectObjects {
+
+    // Turns raw kinect depth (mm) into distance to the background.
+    // The world point of pixel (x, y) at depth z is z * ray(x, y), so its
+    // distance to the plane (n, v0) is |z * n.ray(x, y) - n.v0|. With a learned
+    // background depth b(x, y) it is |c * (z - b(x, y))|, c being n.ray(x, y)
+    // if there is a plane too and 1 otherwise. Either way it is
+    // |coefficient(x, y) * z - offset(x, y)|, computed once per calibration,
+    // leaving one multiply-add per pixel per frame.
+    class DepthSegmenter{
+    public:
+        DepthSegmenter();
+        void setup(int width, int height);
+        void setRays(DepthSource& source);
+        void setRays(const vector<ofVec3f>& rays);
+        bool hasRays() const;
+        void setBackgroundPlane(ofVec3f v0, ofVec3f n);
+        //Per-pixel background depth (mm), 0 where unknown. Unknown pixels are never foreground.
+        void setBackgroundDepth(const vector<float>& depth);
+        void clearBackgroundDepth();
+        bool hasBackgroundPlane() const;
+        bool hasBackgroundDepth() const;
+        bool isReady() const;
+
+        int getWidth() const;
+        int getHeight() const;
+        //Changes whenever the rays or coefficients do, and is never the same
+        //for two segmenters: results computed with a version hold while it lasts
+        unsigned long long getVersion() const;
+
+        float getDistanceToBackground(unsigned short depth, int x, int y) const{
+            return fabsf(coefficients_[y * width_ + x] * depth - offsets_[y * width_ + x]);
+        }
+        
+        ofVec3f getWorldCoordinateAt(const unsigned short* depth, int x, int y) const;
+
+        // Writes both 255/0 masks in a single row-major pass (AVX2 or SSE2 when
+        // available). A pixel in the floor band is never a hand. The masks are
+        // (re)allocated as CV_8UC1 height x width if needed. With a step, only
+        // every step-th pixel of every step-th row is segmented and the masks
+        // are getMaskWidth(step) x getMaskHeight(step).
+        void segment(const unsigned short* depth, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold, int step = 1) const;
+        //Only the pixels of rect (mask coordinates) of masks segment() allocated
+        void segmentRect(const unsigned short* depth, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold, int step, cv::Rect rect) const;
+        int getMaskWidth(int step) const;
+        int getMaskHeight(int step) const;
+        
+        // Reference implementation of segment(), one pixel at a time
+        void segmentScalar(const unsigned short* depth, cv::Mat& objectsMask, cv::Mat& handsMask, ofVec2f floorThreshold, ofVec2f handsThreshold) const;
+
+    private:
+        void updateCoefficients();
+        void updateVersion();
+
+        int width_, height_;
+        unsigned long long version_;
+        vector<ofVec3f> rays_;
+
+        bool bPlane_;
+        vector<float> planeCoefficients_;
+        float planeOffset_;
+        vector<float> backgroundDepth_;
+
+        vector<float> coefficients_;
+        vector<float> offsets_;
+    };
+
+} //namespace ofxKinectObjects
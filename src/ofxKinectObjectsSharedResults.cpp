@@ -0,0 +1,179 @@
+//
+//  ofxKinectObjectsSharedResults.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsSharedResults.h"
+#include <algorithm>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace ofxKinectObjects {
+
+    static size_t alignToCacheLine(size_t size){
+        return (size + 63) & ~size_t(63);
+    }
+
+    uint64_t sharedResultsMicros(){
+    #ifdef _WIN32
+        return 0;
+    #else
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return uint64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+    #endif
+    }
+
+    size_t getSharedSlotSize(uint32_t maxObjects, uint32_t maxHands){
+        return alignToCacheLine(sizeof(SharedSlot) + (maxObjects + maxHands) * sizeof(SharedBlob));
+    }
+
+    size_t getSharedResultsSize(uint32_t slotCount, uint32_t maxObjects, uint32_t maxHands){
+        return alignToCacheLine(sizeof(SharedHeader)) + slotCount * getSharedSlotSize(maxObjects, maxHands);
+    }
+
+    size_t getSharedSlotOffset(const SharedHeader& header, uint64_t frame){
+        return alignToCacheLine(sizeof(SharedHeader)) + ((frame - 1) % header.slotCount) * header.slotSize;
+    }
+
+    SharedResults::SharedResults(){
+        frameNumber = 0;
+        publishedMicros = 0;
+    }
+
+    /***
+     READER
+     **___________________________________*/
+
+    SharedResultsReader::SharedResultsReader(){
+        header_ = NULL;
+        size_ = 0;
+        lastRead_ = 0;
+        missed_ = 0;
+    }
+
+    SharedResultsReader::~SharedResultsReader(){
+        close();
+    }
+
+    bool SharedResultsReader::open(std::string name){
+        close();
+        name_ = name;
+        return map();
+    }
+
+    void SharedResultsReader::close(){
+        unmap();
+        name_.clear();
+    }
+
+    bool SharedResultsReader::isOpen() const{
+        return header_ != NULL;
+    }
+
+    bool SharedResultsReader::map(){
+    #ifdef _WIN32
+        return false;
+    #else
+        int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(SharedHeader)) {
+            mapped = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        header_ = (SharedHeader*)mapped;
+        size_ = info.st_size;
+
+        //The publisher writes the magic last. Anything else is not ready or not ours.
+        bool valid = header_->magic == sharedResultsMagic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        valid = valid && header_->version == sharedResultsVersion && header_->slotCount > 0;
+        valid = valid && size_ >= getSharedResultsSize(header_->slotCount, header_->maxObjects, header_->maxHands);
+        if (!valid) {
+            unmap();
+            return false;
+        }
+        //Only frames published from now on
+        lastRead_ = header_->published.load(std::memory_order_acquire);
+        missed_ = 0;
+        return true;
+    #endif
+    }
+
+    void SharedResultsReader::unmap(){
+    #ifndef _WIN32
+        if (header_) {
+            munmap(header_, size_);
+        }
+    #endif
+        header_ = NULL;
+        size_ = 0;
+    }
+
+    const SharedSlot* SharedResultsReader::getSlot(uint64_t frame) const{
+        return (const SharedSlot*)((const char*)header_ + getSharedSlotOffset(*header_, frame));
+    }
+
+    //--------------------------------------------------------------
+    bool SharedResultsReader::read(SharedResults& results){
+        if (name_.empty()) {
+            return false;
+        }
+        if (header_ && header_->closed.load(std::memory_order_acquire)) {
+            unmap();
+        }
+        if (!header_ && !map()) {
+            return false;
+        }
+
+        //A few tries: only fails if the publisher laps the ring every time
+        for (int attempt = 0; attempt < 4; attempt++) {
+            uint64_t frame = header_->published.load(std::memory_order_acquire);
+            if (frame == lastRead_) {
+                return false;
+            }
+            const SharedSlot* slot = getSlot(frame);
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * frame) {
+                continue;
+            }
+
+            uint32_t objects = std::min(slot->objectCount, header_->maxObjects);
+            uint32_t hands = std::min(slot->handCount, header_->maxHands);
+            const SharedBlob* blobs = (const SharedBlob*)(slot + 1);
+            results.frameNumber = slot->frameNumber;
+            results.publishedMicros = slot->publishedMicros;
+            results.objects.assign(blobs, blobs + objects);
+            results.hands.assign(blobs + header_->maxObjects, blobs + header_->maxObjects + hands);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) == sequence) {
+                missed_ += frame - lastRead_ - 1;
+                lastRead_ = frame;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t SharedResultsReader::getMissedCount() const{
+        return missed_;
+    }
+
+} //namespace ofxKinectObjects
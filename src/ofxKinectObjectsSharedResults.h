@@ -0,0 +1,124 @@
+//
+//  ofxKinectObjectsSharedResults.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Tracking results in POSIX shared memory, for processes on the same
+// machine that don't link openFrameworks. This header and its .cpp only
+// need the standard library: copy them into the consumer and use
+// SharedResultsReader.
+
+namespace ofxKinectObjects {
+
+    static const char* const sharedResultsDefaultName = "/ofxKinectObjects";
+    static const uint32_t sharedResultsMagic = 0x524f4b4f; // "OKOR"
+    static const uint32_t sharedResultsVersion = 2;
+    //No hand: labels start at 0
+    static const uint32_t sharedResultsNoLabel = 0xffffffff;
+
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory needs lock-free 64 bit atomics");
+
+    //An object or a hand, in table coordinates (mm)
+    struct SharedBlob{
+        uint32_t label;
+        //first sensor that sees it
+        int32_t sensor;
+        //objects only, 0 for hands
+        uint32_t category;
+        //objects: label of the hand touching it, sharedResultsNoLabel if not
+        //touched or a hand
+        uint32_t touchedBy;
+        float centroid[3];
+        float quad[4][3];
+        float area;
+    };
+
+    // Memory layout, version sharedResultsVersion. The header is followed by
+    // slotCount slots of slotSize bytes: a SharedSlot and then maxObjects +
+    // maxHands SharedBlobs, objects first.
+    //
+    // Frame n (from 1) goes to slot (n - 1) % slotCount. The publisher sets
+    // the slot sequence to 2n - 1, writes the frame, sets it to 2n and then
+    // sets published to n. A reader copies the slot and keeps the copy if
+    // the sequence was 2n before and after. The publisher never waits for
+    // readers, and a reader only retries if the publisher went all around
+    // the ring while it was copying.
+    struct SharedHeader{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t slotSize;
+        uint32_t maxObjects;
+        uint32_t maxHands;
+        //publisher gone: readers have to open the name again
+        std::atomic<uint32_t> closed;
+        std::atomic<uint64_t> published;
+    };
+
+    struct SharedSlot{
+        std::atomic<uint64_t> sequence;
+        uint64_t frameNumber;
+        //sharedResultsMicros() when published
+        uint64_t publishedMicros;
+        uint32_t objectCount;
+        uint32_t handCount;
+    };
+
+    //Monotonic clock shared by publisher and readers, to measure latency
+    uint64_t sharedResultsMicros();
+
+    //Bytes of a slot and of the whole segment
+    size_t getSharedSlotSize(uint32_t maxObjects, uint32_t maxHands);
+    size_t getSharedResultsSize(uint32_t slotCount, uint32_t maxObjects, uint32_t maxHands);
+    //Where the slot of a frame starts, from the start of the segment
+    size_t getSharedSlotOffset(const SharedHeader& header, uint64_t frame);
+
+    struct SharedResults{
+        SharedResults();
+        uint64_t frameNumber;
+        uint64_t publishedMicros;
+        //Listed once however many sensors see them, as in FrameSnapshot
+        std::vector<SharedBlob> objects;
+        std::vector<SharedBlob> hands;
+    };
+
+    // Reads the latest results of a ResultsPublisher. Opening is retried on
+    // every read until the publisher is there, and done again when it
+    // restarts, so readers can start before the tracker.
+    class SharedResultsReader{
+    public:
+        SharedResultsReader();
+        ~SharedResultsReader();
+        bool open(std::string name = sharedResultsDefaultName);
+        void close();
+        bool isOpen() const;
+        //Copies the latest frame if it is newer than the last one read
+        bool read(SharedResults& results);
+        //Frames published but never read, since open()
+        uint64_t getMissedCount() const;
+
+    private:
+        bool map();
+        void unmap();
+        const SharedSlot* getSlot(uint64_t frame) const;
+
+        std::string name_;
+        SharedHeader* header_;
+        size_t size_;
+        uint64_t lastRead_;
+        uint64_t missed_;
+
+        SharedResultsReader(const SharedResultsReader&);
+        SharedResultsReader& operator=(const SharedResultsReader&);
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,104 @@
+//
+//  ofxKinectObjectsSlotMap.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+namespace ofxKinectObjects {
+
+    // Values keyed by tracker label, stored contiguously. Erased slots are
+    // reused, so memory stays at the peak number of live values.
+    template <class T>
+    class SlotMap{
+    public:
+        //NULL if there is no value for key
+        T* find(unsigned int key){
+            typename std::unordered_map<unsigned int, unsigned int>::iterator it = slots_.find(key);
+            return it == slots_.end() ? NULL : &values_[it->second];
+        }
+
+        //Inserts or replaces the value for key
+        T& insert(unsigned int key, const T& value){
+            T* existing = find(key);
+            if (existing) {
+                *existing = value;
+                return *existing;
+            }
+            unsigned int slot;
+            if (freeSlots_.empty()) {
+                slot = values_.size();
+                values_.push_back(value);
+                keys_.push_back(key);
+                alive_.push_back(true);
+            } else {
+                slot = freeSlots_.back();
+                freeSlots_.pop_back();
+                values_[slot] = value;
+                keys_[slot] = key;
+                alive_[slot] = true;
+            }
+            slots_[key] = slot;
+            return values_[slot];
+        }
+
+        bool erase(unsigned int key){
+            typename std::unordered_map<unsigned int, unsigned int>::iterator it = slots_.find(key);
+            if (it == slots_.end()) {
+                return false;
+            }
+            alive_[it->second] = false;
+            freeSlots_.push_back(it->second);
+            slots_.erase(it);
+            return true;
+        }
+
+        void erase(const std::vector<unsigned int>& keys){
+            for (int i = 0; i < keys.size(); i++) {
+                erase(keys[i]);
+            }
+        }
+
+        void clear(){
+            values_.clear();
+            keys_.clear();
+            alive_.clear();
+            freeSlots_.clear();
+            slots_.clear();
+        }
+
+        int size() const{
+            return slots_.size();
+        }
+
+        //Slot iteration: for (int i = 0; i < getSlotCount(); i++) if (isAlive(i)) ...
+        int getSlotCount() const{
+            return values_.size();
+        }
+
+        bool isAlive(int slot) const{
+            return alive_[slot];
+        }
+
+        unsigned int getKey(int slot) const{
+            return keys_[slot];
+        }
+
+        T& getSlot(int slot){
+            return values_[slot];
+        }
+
+    private:
+        std::vector<T> values_;
+        std::vector<unsigned int> keys_;
+        std::vector<bool> alive_;
+        std::vector<unsigned int> freeSlots_;
+        std::unordered_map<unsigned int, unsigned int> slots_;
+    };
+
+} //namespace ofxKinectObjects
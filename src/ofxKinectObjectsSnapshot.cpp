@@ -0,0 +1,33 @@
+//
+//  ofxKinectObjectsSnapshot.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsSnapshot.h"
+
+namespace ofxKinectObjects {
+
+    HandState::HandState(){
+        label = 0;
+        sensor = 0;
+        area = 0;
+        minHeight = maxHeight = meanHeight = 0;
+    }
+
+    ObjectState::ObjectState(){
+        category = 0;
+        touchedBy = noLabel;
+    }
+
+    bool ObjectState::isTouched() const{
+        return touchedBy != noLabel;
+    }
+
+    FrameSnapshot::FrameSnapshot(){
+        frameNumber = 0;
+    }
+
+} //namespace ofxKinectObjects
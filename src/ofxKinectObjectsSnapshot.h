@@ -0,0 +1,53 @@
+//
+//  ofxKinectObjectsSnapshot.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+namespace ofxKinectObjects {
+
+    //No object or hand: trackers give label 0 like any other
+    static const unsigned int noLabel = (unsigned int)-1;
+
+    struct HandState{
+        HandState();
+        unsigned int label;
+        //first sensor that sees it, whose pixels centroid and quad are in
+        int sensor;
+        //kinect pixels
+        ofPoint centroid;
+        vector<ofPoint> quad;
+        //table (mm), world coordinates with a single sensor
+        ofVec3f worldCentroid;
+        vector<ofVec3f> worldQuad;
+        //sum of two adjacent world edges of the quad
+        float area;
+        //distance of its pixels to the background (mm)
+        float minHeight, maxHeight, meanHeight;
+    };
+
+    struct ObjectState : public HandState{
+        ObjectState();
+        bool isTouched() const;
+        unsigned int category;
+        //hand label, noLabel if not touched
+        unsigned int touchedBy;
+    };
+
+    // Everything ObjectTracker knows about one tracking result, computed once
+    // in update(). Draw and query code reads it instead of going back to the
+    // kinect or the contour finders. An object or hand seen by several sensors
+    // is listed once, with the mean of their table coordinates.
+    struct FrameSnapshot{
+        FrameSnapshot();
+        unsigned long long frameNumber;
+        vector<ObjectState> objects;
+        vector<HandState> hands;
+    };
+
+} //namespace ofxKinectObjects
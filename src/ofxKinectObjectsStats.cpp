@@ -0,0 +1,228 @@
+//
+//  ofxKinectObjectsStats.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsStats.h"
+
+namespace ofxKinectObjects {
+
+    const char* getStageName(Stage stage){
+        switch (stage) {
+            case STAGE_KINECT: return "kinect";
+            case STAGE_SEGMENTATION: return "segmentation";
+            case STAGE_OBJECT_CONTOURS: return "object contours";
+            case STAGE_HAND_CONTOURS: return "hand contours";
+            case STAGE_FUSION: return "fusion";
+            case STAGE_BOOKKEEPING: return "bookkeeping";
+            case STAGE_EVENTS: return "events";
+            case STAGE_UPDATE: return "update";
+            default: return "";
+        }
+    }
+
+#ifdef OFX_KINECT_OBJECTS_STATS
+    StageTimes::StageTimes(){
+        clear();
+    }
+
+    void StageTimes::clear(){
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            micros[i] = -1;
+        }
+    }
+#endif
+
+    /***
+     STAGE HISTOGRAM
+     **___________________________________*/
+
+    StageHistogram::StageHistogram(){
+        next_ = count_ = 0;
+    }
+
+    void StageHistogram::setup(int size){
+        samples_.assign(size, 0);
+        clear();
+    }
+
+    void StageHistogram::clear(){
+        next_ = count_ = 0;
+    }
+
+    void StageHistogram::add(float micros){
+        if (samples_.empty()) {
+            return;
+        }
+        samples_[next_] = micros;
+        next_ = (next_ + 1) % samples_.size();
+        count_ = MIN(count_ + 1, int(samples_.size()));
+    }
+
+    int StageHistogram::getCount() const{
+        return count_;
+    }
+
+    float StageHistogram::getPercentile(float p) const{
+        if (count_ == 0) {
+            return 0;
+        }
+        sorted_.assign(samples_.begin(), samples_.begin() + count_);
+        int k = ofClamp(p, 0, 1) * (count_ - 1) + 0.5f;
+        nth_element(sorted_.begin(), sorted_.begin() + k, sorted_.end());
+        return sorted_[k];
+    }
+
+    float StageHistogram::getMean() const{
+        if (count_ == 0) {
+            return 0;
+        }
+        float sum = 0;
+        for (int i = 0; i < count_; i++) {
+            sum += samples_[i];
+        }
+        return sum / count_;
+    }
+
+    /***
+     TRACKER STATS
+     **___________________________________*/
+
+    TrackerStats::TrackerStats(){
+        dumpInterval_ = 1;
+        lastDump_ = 0;
+        setup();
+    }
+
+    void TrackerStats::setup(int window){
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            stages_[i].setup(window);
+        }
+        reset();
+    }
+
+    void TrackerStats::reset(){
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            stages_[i].clear();
+        }
+        framesProcessed_ = framesDropped_ = 0;
+        objectRefreshes_ = objectRefreshesShed_ = 0;
+        objects_ = hands_ = 0;
+    }
+
+    //--------------------------------------------------------------
+    void TrackerStats::addTimes(const StageTimes& times){
+#ifdef OFX_KINECT_OBJECTS_STATS
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            if (times.micros[i] >= 0) {
+                stages_[i].add(times.micros[i]);
+            }
+        }
+#endif
+    }
+
+    void TrackerStats::addFrame(int dropped, bool objectsRefreshed, bool objectsShed){
+        framesProcessed_++;
+        framesDropped_ += dropped;
+        objectRefreshes_ += objectsRefreshed;
+        objectRefreshesShed_ += objectsShed;
+    }
+
+    void TrackerStats::setCounts(int objects, int hands){
+        objects_ = objects;
+        hands_ = hands;
+    }
+
+    //--------------------------------------------------------------
+    const StageHistogram& TrackerStats::getStage(Stage stage) const{
+        return stages_[stage];
+    }
+
+    float TrackerStats::getPercentile(Stage stage, float p) const{
+        return stages_[stage].getPercentile(p);
+    }
+
+    unsigned long long TrackerStats::getFramesProcessed() const{
+        return framesProcessed_;
+    }
+
+    unsigned long long TrackerStats::getFramesDropped() const{
+        return framesDropped_;
+    }
+
+    unsigned long long TrackerStats::getObjectRefreshes() const{
+        return objectRefreshes_;
+    }
+
+    unsigned long long TrackerStats::getObjectRefreshesShed() const{
+        return objectRefreshesShed_;
+    }
+
+    int TrackerStats::getObjectCount() const{
+        return objects_;
+    }
+
+    int TrackerStats::getHandCount() const{
+        return hands_;
+    }
+
+    //--------------------------------------------------------------
+    void TrackerStats::draw(int x, int y) const{
+        string text = "stage (us)        p50     p95     p99\n";
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            const StageHistogram& stage = stages_[i];
+            string name = getStageName(Stage(i));
+            text += name + string(17 - name.size(), ' ');
+            text += ofToString(int(stage.getPercentile(0.5f)), 7, ' ') + " ";
+            text += ofToString(int(stage.getPercentile(0.95f)), 7, ' ') + " ";
+            text += ofToString(int(stage.getPercentile(0.99f)), 7, ' ') + "\n";
+        }
+        text += "frames " + ofToString(framesProcessed_) + ", dropped " + ofToString(framesDropped_) + "\n";
+        text += "object refreshes " + ofToString(objectRefreshes_) + ", shed " + ofToString(objectRefreshesShed_) + "\n";
+        text += "objects " + ofToString(objects_) + ", hands " + ofToString(hands_);
+        ofDrawBitmapString(text, x, y);
+    }
+
+    //--------------------------------------------------------------
+    void TrackerStats::setDump(string path, float interval){
+        dumpPath_ = path;
+        dumpInterval_ = interval;
+        lastDump_ = ofGetElapsedTimef();
+        if (dumpPath_.empty()) {
+            return;
+        }
+
+        ofstream file(ofToDataPath(dumpPath_).c_str());
+        if (!file) {
+            ofLogError("TrackerStats") << "setDump(): can't write " << dumpPath_;
+            dumpPath_.clear();
+            return;
+        }
+        file << "time,frames,dropped,object_refreshes,object_refreshes_shed,objects,hands";
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            string name = ofJoinString(ofSplitString(getStageName(Stage(i)), " "), "_");
+            file << "," << name << "_p50," << name << "_p95," << name << "_p99";
+        }
+        file << "\n";
+    }
+
+    void TrackerStats::dumpIfDue(){
+        float now = ofGetElapsedTimef();
+        if (dumpPath_.empty() || now - lastDump_ < dumpInterval_) {
+            return;
+        }
+        lastDump_ = now;
+
+        ofstream file(ofToDataPath(dumpPath_).c_str(), ios::app);
+        file << now << "," << framesProcessed_ << "," << framesDropped_ << "," << objectRefreshes_ << "," << objectRefreshesShed_ << "," << objects_ << "," << hands_;
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            const StageHistogram& stage = stages_[i];
+            file << "," << stage.getPercentile(0.5f) << "," << stage.getPercentile(0.95f) << "," << stage.getPercentile(0.99f);
+        }
+        file << "\n";
+    }
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,129 @@
+//
+//  ofxKinectObjectsStats.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include <chrono>
+#include "ofMain.h"
+
+// Define OFX_KINECT_OBJECTS_STATS to time the stages of ObjectTracker::update()
+// and the detection pipeline. Without it the timers are empty and the tracker
+// has no stats API.
+
+namespace ofxKinectObjects {
+
+    enum Stage{
+        //DepthSource::update() and copying the depth frame
+        STAGE_KINECT,
+        STAGE_SEGMENTATION,
+        STAGE_OBJECT_CONTOURS,
+        STAGE_HAND_CONTOURS,
+        STAGE_FUSION,
+        //objects table, snapshot and touches
+        STAGE_BOOKKEEPING,
+        //hand events
+        STAGE_EVENTS,
+        //whole ObjectTracker::update()
+        STAGE_UPDATE,
+        STAGE_COUNT
+    };
+
+    const char* getStageName(Stage stage);
+
+#ifdef OFX_KINECT_OBJECTS_STATS
+    //Stage times of one frame (microseconds), filled where the frame is processed.
+    //Stages that did not run are negative.
+    struct StageTimes{
+        StageTimes();
+        void clear();
+        float micros[STAGE_COUNT];
+    };
+
+    //Adds the time until it goes out of scope to times.micros[stage]
+    class ScopedStageTimer{
+    public:
+        ScopedStageTimer(StageTimes& times, Stage stage) : times_(times), stage_(stage), start_(std::chrono::steady_clock::now()) {}
+        ~ScopedStageTimer(){
+            times_.micros[stage_] = MAX(times_.micros[stage_], 0.f) + std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start_).count();
+        }
+
+    private:
+        StageTimes& times_;
+        Stage stage_;
+        std::chrono::steady_clock::time_point start_;
+    };
+#else
+    struct StageTimes{
+        void clear() {}
+    };
+
+    class ScopedStageTimer{
+    public:
+        ScopedStageTimer(StageTimes&, Stage) {}
+    };
+#endif
+
+    // Last samples of one stage. Percentiles are computed when asked for, so
+    // adding a sample is just a store.
+    class StageHistogram{
+    public:
+        StageHistogram();
+        void setup(int size);
+        void clear();
+        void add(float micros);
+        int getCount() const;
+        //p in [0, 1], 0 if there are no samples
+        float getPercentile(float p) const;
+        float getMean() const;
+
+    private:
+        vector<float> samples_;
+        int next_, count_;
+        mutable vector<float> sorted_;
+    };
+
+    // Stage histograms and frame counters of an ObjectTracker. Written from
+    // update() only, so it needs no locking: the pipeline threads send their
+    // times along with their results.
+    class TrackerStats{
+    public:
+        TrackerStats();
+        //Number of frames the percentiles are computed over
+        void setup(int window = 300);
+        void reset();
+
+        void addTimes(const StageTimes& times);
+        //Objects refreshed on the frame, or not because the frame budget was spent
+        void addFrame(int dropped, bool objectsRefreshed = true, bool objectsShed = false);
+        void setCounts(int objects, int hands);
+
+        const StageHistogram& getStage(Stage stage) const;
+        float getPercentile(Stage stage, float p) const;
+        //Depth frames tracked, and skipped because tracking was busy
+        unsigned long long getFramesProcessed() const;
+        unsigned long long getFramesDropped() const;
+        unsigned long long getObjectRefreshes() const;
+        unsigned long long getObjectRefreshesShed() const;
+        int getObjectCount() const;
+        int getHandCount() const;
+
+        void draw(int x, int y) const;
+
+        //Append a CSV line to path every interval seconds, from update(). Empty path stops.
+        void setDump(string path, float interval);
+        void dumpIfDue();
+
+    private:
+        StageHistogram stages_[STAGE_COUNT];
+        unsigned long long framesProcessed_, framesDropped_;
+        unsigned long long objectRefreshes_, objectRefreshesShed_;
+        int objects_, hands_;
+        string dumpPath_;
+        float dumpInterval_, lastDump_;
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,252 @@
+//
+//  ofxKinectObjectsSyntheticSource.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsSyntheticSource.h"
+
+namespace ofxKinectObjects {
+
+    //Kinect at 640x480: 0.1042 mm zero plane pixel size at 120 mm
+    static const float zeroPlanePixelSize = 0.1042;
+    static const float zeroPlaneDistance = 120;
+    //Table center, objects and hands (mm)
+    static const float tableDistance = 1200;
+    static const float objectHeight = 50;
+    static const float handHeight = 150;
+
+    SyntheticSource::SyntheticSource(int width, int height){
+        width_ = width;
+        height_ = height;
+        scale_ = width / 640.f;
+        objectCount_ = 8;
+        handCount_ = 2;
+        touchPeriod_ = 90;
+        noise_ = 2;
+        tilt_ = 10;
+        seed_ = random_ = 1;
+        bEmpty_ = false;
+        frameNumber_ = 0;
+        bDepthImageDirty = false;
+    }
+
+    //--------------------------------------------------------------
+    void SyntheticSource::setObjectCount(int objects){
+        objectCount_ = MAX(objects, 0);
+    }
+
+    void SyntheticSource::setHandCount(int hands){
+        handCount_ = MAX(hands, 0);
+    }
+
+    void SyntheticSource::setNoise(float noise){
+        noise_ = noise;
+    }
+
+    void SyntheticSource::setTableTilt(float degrees){
+        tilt_ = degrees;
+    }
+
+    void SyntheticSource::setSeed(unsigned int seed){
+        seed_ = MAX(seed, 1u);
+    }
+
+    void SyntheticSource::setTouchPeriod(int frames){
+        touchPeriod_ = MAX(frames, 8);
+    }
+
+    void SyntheticSource::setEmpty(bool empty){
+        bEmpty_ = empty;
+    }
+
+    //--------------------------------------------------------------
+    bool SyntheticSource::setup(){
+        //Table plane through (0, 0, tableDistance), tilted around the x axis
+        float factor = 2 * getZeroPlanePixelSize() / getZeroPlaneDistance();
+        ofVec3f normal(0, sin(ofDegToRad(tilt_)), cos(ofDegToRad(tilt_)));
+        float planeOffset = normal.z * tableDistance;
+        table_.resize(width_ * height_);
+        for (int j = 0; j < height_; j++) {
+            for (int i = 0; i < width_; i++) {
+                ofVec3f ray((i - width_ / 2) * factor, (j - height_ / 2) * factor, 1);
+                table_[j * width_ + i] = planeOffset / normal.dot(ray);
+            }
+        }
+
+        depth_.assign(width_ * height_, 0);
+        random_ = seed_;
+        frameNumber_ = 0;
+        layout();
+        return true;
+    }
+
+    //Objects on a grid, each with room on its right for a hand
+    void SyntheticSource::layout(){
+        float objectSize = 36 * scale_, handLength = 44 * scale_, reach = 24 * scale_, margin = 12 * scale_;
+        int columns = (width_ - margin) / (objectSize + reach + handLength + margin);
+        int rows = (height_ - margin) / (objectSize + margin);
+        if (objectCount_ > columns * rows) {
+            ofLogNotice("SyntheticSource") << "setup(): " << objectCount_ << " objects don't fit in " << width_ << "x" << height_ << ", using " << columns * rows;
+            objectCount_ = columns * rows;
+        }
+        handCount_ = MIN(handCount_, objectCount_);
+
+        objects_.resize(objectCount_);
+        for (int i = 0; i < objectCount_; i++) {
+            float x = margin + (i % columns) * (objectSize + reach + handLength + margin);
+            float y = margin + (i / columns) * (objectSize + margin);
+            objects_[i].set(x, y, objectSize, objectSize);
+        }
+        hands_.resize(handCount_);
+        touched_.assign(handCount_, -1);
+    }
+
+    // Every touch period each hand takes an object: comes from the right,
+    // overlaps its right edge, stays, and goes back. The hands take
+    // different objects, and next period the next ones.
+    void SyntheticSource::placeHands(){
+        float handLength = 44 * scale_, handWidth = 14 * scale_, reach = 24 * scale_, overlap = 6 * scale_;
+        int period = frameNumber_ / touchPeriod_;
+        int phase = frameNumber_ % touchPeriod_;
+        int approach = touchPeriod_ / 4, stay = touchPeriod_ / 3, leave = touchPeriod_ / 4;
+
+        float gap = reach;
+        if (phase < approach) {
+            gap = ofLerp(reach, -overlap, phase / float(approach));
+        } else if (phase < approach + stay) {
+            gap = -overlap;
+        } else if (phase < approach + stay + leave) {
+            gap = ofLerp(-overlap, reach, (phase - approach - stay) / float(leave));
+        }
+
+        for (int h = 0; h < handCount_; h++) {
+            int object = (h + period * handCount_) % objectCount_;
+            const ofRectangle& rect = objects_[object];
+            hands_[h].set(rect.getRight() + gap, rect.getCenter().y - handWidth / 2, handLength, handWidth);
+            touched_[h] = gap < 0 ? object : -1;
+        }
+    }
+
+    //--------------------------------------------------------------
+    void SyntheticSource::update(){
+        frameNumber_++;
+        placeHands();
+
+        for (int i = 0; i < width_ * height_; i++) {
+            depth_[i] = table_[i] + noise() + 0.5f;
+        }
+        if (!bEmpty_) {
+            for (int i = 0; i < objects_.size(); i++) {
+                fillRect(objects_[i], objectHeight);
+            }
+            //Above the objects they touch
+            for (int i = 0; i < hands_.size(); i++) {
+                fillRect(hands_[i], handHeight);
+            }
+        }
+        bDepthImageDirty = true;
+    }
+
+    void SyntheticSource::fillRect(const ofRectangle& rect, float height){
+        int x0 = MAX(int(rect.x), 0), x1 = MIN(int(rect.getRight()), width_);
+        int y0 = MAX(int(rect.y), 0), y1 = MIN(int(rect.getBottom()), height_);
+        for (int j = y0; j < y1; j++) {
+            for (int i = x0; i < x1; i++) {
+                depth_[j * width_ + i] = table_[j * width_ + i] - height + noise() + 0.5f;
+            }
+        }
+    }
+
+    //Roughly gaussian: sum of three uniforms, xorshift
+    float SyntheticSource::noise(){
+        float sum = 0;
+        for (int k = 0; k < 3; k++) {
+            random_ ^= random_ << 13;
+            random_ ^= random_ >> 17;
+            random_ ^= random_ << 5;
+            sum += random_ * (2.f / 4294967296.f) - 1;
+        }
+        return sum * noise_;
+    }
+
+    //--------------------------------------------------------------
+    bool SyntheticSource::isFrameNew(){
+        return frameNumber_ > 0;
+    }
+
+    const unsigned short* SyntheticSource::getDepthPixels(){
+        return &depth_[0];
+    }
+
+    int SyntheticSource::getWidth(){
+        return width_;
+    }
+
+    int SyntheticSource::getHeight(){
+        return height_;
+    }
+
+    //As a kinect, at 30fps
+    double SyntheticSource::getTimestamp(){
+        return frameNumber_ / 30.0;
+    }
+
+    //Same as freenect_camera_to_world()
+    ofVec3f SyntheticSource::getWorldCoordinateAt(float x, float y, float z){
+        float factor = 2 * getZeroPlanePixelSize() * z / getZeroPlaneDistance();
+        return ofVec3f((int(x) - width_ / 2) * factor, (int(y) - height_ / 2) * factor, z);
+    }
+
+    //Same field of view as a kinect at any resolution
+    float SyntheticSource::getZeroPlanePixelSize(){
+        return zeroPlanePixelSize / scale_;
+    }
+
+    float SyntheticSource::getZeroPlaneDistance(){
+        return zeroPlaneDistance;
+    }
+
+    void SyntheticSource::drawDepth(float x, float y, float w, float h){
+        drawDepthImage(depthImage, bDepthImageDirty, x, y, w, h);
+    }
+
+    void SyntheticSource::close(){
+    }
+
+    //--------------------------------------------------------------
+    unsigned long long SyntheticSource::getFrameNumber(){
+        return frameNumber_;
+    }
+
+    int SyntheticSource::getObjectCount(){
+        return objects_.size();
+    }
+
+    int SyntheticSource::getHandCount(){
+        return hands_.size();
+    }
+
+    ofRectangle SyntheticSource::getObjectRect(int object){
+        return objects_[object];
+    }
+
+    ofRectangle SyntheticSource::getHandRect(int hand){
+        return hands_[hand];
+    }
+
+    int SyntheticSource::getTouchedObject(int hand){
+        return touched_[hand];
+    }
+
+    float SyntheticSource::getObjectHeight(){
+        return objectHeight;
+    }
+
+    float SyntheticSource::getHandHeight(){
+        return handHeight;
+    }
+
+} //namespace ofxKinectObjects
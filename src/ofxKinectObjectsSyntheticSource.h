@@ -0,0 +1,87 @@
+//
+//  ofxKinectObjectsSyntheticSource.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsDepthSource.h"
+
+namespace ofxKinectObjects {
+
+    // Depth frames of a made-up scene, seen by a kinect-like camera: a
+    // tilted table with sensor noise, box-shaped objects on it and hands
+    // that go to an object, stay on it and leave, on a fixed schedule. It
+    // knows which hand touches which object, so benchmarks can check the
+    // tracker against it. A new frame on every update().
+    class SyntheticSource : public DepthSource{
+    public:
+        SyntheticSource(int width = 640, int height = 480);
+        using DepthSource::getWorldCoordinateAt;
+
+        //Scene, before setup(). Objects are clamped to what fits in the frame,
+        //hands to the number of objects.
+        void setObjectCount(int objects);
+        void setHandCount(int hands);
+        //Standard deviation of the depth noise (mm)
+        void setNoise(float noise);
+        void setTableTilt(float degrees);
+        void setSeed(unsigned int seed);
+        //Frames a hand takes to go to an object, touch it, and leave
+        void setTouchPeriod(int frames);
+
+        //Only the table, e.g. while the tracker learns the background
+        void setEmpty(bool empty);
+
+        bool setup();
+        void update();
+        bool isFrameNew();
+        const unsigned short* getDepthPixels();
+        int getWidth();
+        int getHeight();
+        double getTimestamp();
+        ofVec3f getWorldCoordinateAt(float x, float y, float z);
+        float getZeroPlanePixelSize();
+        float getZeroPlaneDistance();
+        void drawDepth(float x, float y, float w, float h);
+        void close();
+
+        //Ground truth of the current frame. Frames are numbered from 1, as the tracker does.
+        unsigned long long getFrameNumber();
+        int getObjectCount();
+        int getHandCount();
+        ofRectangle getObjectRect(int object);
+        ofRectangle getHandRect(int hand);
+        //Object the hand touches, -1 if none
+        int getTouchedObject(int hand);
+        //Above the table (mm), to choose the tracker thresholds
+        float getObjectHeight();
+        float getHandHeight();
+
+    private:
+        void layout();
+        void placeHands();
+        void fillRect(const ofRectangle& rect, float height);
+        float noise();
+
+        int width_, height_;
+        float scale_;
+        int objectCount_, handCount_, touchPeriod_;
+        float noise_, tilt_;
+        unsigned int seed_, random_;
+        bool bEmpty_;
+
+        vector<float> table_;
+        vector<unsigned short> depth_;
+        vector<ofRectangle> objects_;
+        vector<ofRectangle> hands_;
+        vector<int> touched_;
+        unsigned long long frameNumber_;
+
+        ofImage depthImage;
+        bool bDepthImageDirty;
+    };
+
+} //namespace ofxKinectObjects
@@ -0,0 +1,101 @@
+//
+//  ofxKinectObjectsTouchIndex.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsTouchIndex.h"
+
+namespace ofxKinectObjects {
+
+    bool quadContains(const vector<ofPoint>& quad, float x, float y){
+        bool inside = false;
+        for (int i = 0, j = quad.size() - 1; i < quad.size(); j = i++) {
+            if ((quad[i].y > y) != (quad[j].y > y) &&
+                x < (quad[j].x - quad[i].x) * (y - quad[i].y) / (quad[j].y - quad[i].y) + quad[i].x) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    //--------------------------------------------------------------
+    TouchIndex::TouchIndex(){
+        width_ = height_ = columns_ = rows_ = 0;
+        cellSize_ = 32;
+        queryNumber_ = 0;
+    }
+
+    void TouchIndex::setup(int width, int height, int cellSize){
+        width_ = width;
+        height_ = height;
+        cellSize_ = cellSize;
+        columns_ = (width + cellSize - 1) / cellSize;
+        rows_ = (height + cellSize - 1) / cellSize;
+        cells_.assign(columns_ * rows_, vector<int>());
+        clear();
+    }
+
+    void TouchIndex::clear(){
+        //keep the cells' capacity from frame to frame
+        for (int i = 0; i < cells_.size(); i++) {
+            cells_[i].clear();
+        }
+        quads_.clear();
+        ids_.clear();
+        visited_.clear();
+    }
+
+    //--------------------------------------------------------------
+    void TouchIndex::add(int id, const vector<ofPoint>& quad){
+        if (quad.empty() || cells_.empty()) {
+            return;
+        }
+        float minX = quad[0].x, maxX = quad[0].x, minY = quad[0].y, maxY = quad[0].y;
+        for (int k = 1; k < quad.size(); k++) {
+            minX = MIN(minX, quad[k].x);
+            maxX = MAX(maxX, quad[k].x);
+            minY = MIN(minY, quad[k].y);
+            maxY = MAX(maxY, quad[k].y);
+        }
+        int column0 = ofClamp(int(minX) / cellSize_, 0, columns_ - 1);
+        int column1 = ofClamp(int(maxX) / cellSize_, 0, columns_ - 1);
+        int row0 = ofClamp(int(minY) / cellSize_, 0, rows_ - 1);
+        int row1 = ofClamp(int(maxY) / cellSize_, 0, rows_ - 1);
+
+        int index = quads_.size();
+        quads_.push_back(quad);
+        ids_.push_back(id);
+        visited_.push_back(0);
+        for (int row = row0; row <= row1; row++) {
+            for (int column = column0; column <= column1; column++) {
+                cells_[row * columns_ + column].push_back(index);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------
+    void TouchIndex::query(const vector<ofPoint>& quad, vector<int>& ids){
+        ids.clear();
+        if (cells_.empty()) {
+            return;
+        }
+        queryNumber_++;
+        for (int k = 0; k < quad.size(); k++) {
+            if (quad[k].x < 0 || quad[k].y < 0 || quad[k].x >= columns_ * cellSize_ || quad[k].y >= rows_ * cellSize_) {
+                continue;
+            }
+            const vector<int>& cell = cells_[int(quad[k].y) / cellSize_ * columns_ + int(quad[k].x) / cellSize_];
+            for (int c = 0; c < cell.size(); c++) {
+                int index = cell[c];
+                if (visited_[index] != queryNumber_ && quadContains(quads_[index], quad[k].x, quad[k].y)) {
+                    visited_[index] = queryNumber_;
+                    ids.push_back(ids_[index]);
+                }
+            }
+        }
+    }
+
+} //namespace ofxKinectObjects
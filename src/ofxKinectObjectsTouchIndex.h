@@ -0,0 +1,39 @@
+//
+//  ofxKinectObjectsTouchIndex.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+namespace ofxKinectObjects {
+
+    //Even-odd test, as ofPolyline::inside() but without building a polyline
+    bool quadContains(const vector<ofPoint>& quad, float x, float y);
+
+    // Uniform grid over the object quads of one frame, in kinect pixels. Each
+    // quad is listed in the cells its bounding box covers, so a hand only
+    // tests the objects around its own corners.
+    class TouchIndex{
+    public:
+        TouchIndex();
+        void setup(int width, int height, int cellSize = 32);
+        void clear();
+        void add(int id, const vector<ofPoint>& quad);
+
+        //Ids of the indexed quads containing any corner of quad, each once
+        void query(const vector<ofPoint>& quad, vector<int>& ids);
+
+    private:
+        int width_, height_, cellSize_, columns_, rows_;
+        vector<vector<ofPoint> > quads_;
+        vector<int> ids_;
+        vector<vector<int> > cells_;
+        vector<unsigned int> visited_;
+        unsigned int queryNumber_;
+    };
+
+} //namespace ofxKinectObjects
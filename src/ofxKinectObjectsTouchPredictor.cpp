@@ -0,0 +1,222 @@
+//
+//  ofxKinectObjectsTouchPredictor.cpp
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#include "ofxKinectObjectsTouchPredictor.h"
+
+namespace ofxKinectObjects {
+
+    static const float kinectFrameMillis = 1000 / 30.f;
+
+    MotionFilter::MotionFilter(){
+        reset(0);
+    }
+
+    //Position as measured, velocity unknown
+    void MotionFilter::reset(float position_){
+        position = position_;
+        velocity = 0;
+        p00 = 1;
+        p01 = 0;
+        p11 = 100;
+    }
+
+    // Constant velocity, with white noise acceleration of processNoise per frame
+    void MotionFilter::update(float measurement, float frames, float processNoise, float measurementNoise){
+        float q = processNoise * processNoise, r = measurementNoise * measurementNoise;
+        float dt = frames, dt2 = frames * frames;
+        position += velocity * dt;
+        p00 += dt * (2 * p01 + dt * p11) + q * dt2 * dt2 / 4;
+        p01 += dt * p11 + q * dt2 * dt / 2;
+        p11 += q * dt2;
+
+        float s = p00 + r;
+        float k0 = p00 / s, k1 = p01 / s;
+        float innovation = measurement - position;
+        position += k0 * innovation;
+        velocity += k1 * innovation;
+        p11 -= k1 * p01;
+        p00 *= 1 - k0;
+        p01 *= 1 - k0;
+    }
+
+    float MotionFilter::predict(float frames) const{
+        return position + velocity * frames;
+    }
+
+    HandMotion::HandMotion(){
+        sensor = 0;
+        frameNumber = 0;
+        observations = 0;
+        bHeight = false;
+    }
+
+    /***
+     TOUCH PREDICTOR
+     **___________________________________*/
+
+    TouchPredictor::TouchPredictor(){
+        lookAheadFrames_ = 0;
+        onFrames_ = 2;
+        offFrames_ = 3;
+        processNoise_ = 1;
+        measurementNoise_ = 2;
+    }
+
+    void TouchPredictor::setLookAhead(float millis){
+        lookAheadFrames_ = MAX(millis, 0.f) / kinectFrameMillis;
+    }
+
+    float TouchPredictor::getLookAhead() const{
+        return lookAheadFrames_ * kinectFrameMillis;
+    }
+
+    bool TouchPredictor::isEnabled() const{
+        return lookAheadFrames_ > 0;
+    }
+
+    void TouchPredictor::setHysteresis(int onFrames, int offFrames){
+        onFrames_ = MAX(onFrames, 1);
+        offFrames_ = MAX(offFrames, 1);
+    }
+
+    void TouchPredictor::setNoise(float processNoise, float measurementNoise){
+        processNoise_ = MAX(processNoise, 0.f);
+        measurementNoise_ = MAX(measurementNoise, 0.01f);
+    }
+
+    //--------------------------------------------------------------
+    void TouchPredictor::updateHands(const vector<TrackedBlob>& hands, const vector<unsigned int>& deadHandLabels, unsigned long long frameNumber){
+        motions.erase(deadHandLabels);
+        seen.clear();
+        for (int i = 0; i < hands.size(); i++) {
+            const TrackedBlob& hand = hands[i];
+            if (find(seen.begin(), seen.end(), hand.label) != seen.end()) {
+                continue;
+            }
+            seen.push_back(hand.label);
+
+            // a hand that moved to another sensor has its pixels somewhere else
+            HandMotion* motion = motions.find(hand.label);
+            bool bHeight = hand.meanHeight > 0;
+            if (!motion || motion->sensor != hand.sensor || frameNumber <= motion->frameNumber) {
+                motion = &motions.insert(hand.label, HandMotion());
+                motion->sensor = hand.sensor;
+                motion->x.reset(hand.centroid.x);
+                motion->y.reset(hand.centroid.y);
+                motion->height.reset(hand.meanHeight);
+            } else {
+                float frames = frameNumber - motion->frameNumber;
+                motion->x.update(hand.centroid.x, frames, processNoise_, measurementNoise_);
+                motion->y.update(hand.centroid.y, frames, processNoise_, measurementNoise_);
+                if (bHeight && motion->bHeight) {
+                    motion->height.update(hand.meanHeight, frames, processNoise_, measurementNoise_);
+                } else {
+                    motion->height.reset(hand.meanHeight);
+                }
+            }
+            motion->bHeight = bHeight;
+            motion->frameNumber = frameNumber;
+            motion->observations++;
+        }
+    }
+
+    bool TouchPredictor::predictQuad(const TrackedBlob& hand, vector<ofPoint>& quad){
+        HandMotion* motion = motions.find(hand.label);
+        if (!motion || motion->sensor != hand.sensor || motion->observations < 2) {
+            return false;
+        }
+        //Without a height there is no telling a hand on its way down from one leaving
+        if (!motion->bHeight) {
+            return false;
+        }
+        //Going up by more than the noise before the look-ahead is over
+        if (motion->bHeight && motion->height.velocity * lookAheadFrames_ > measurementNoise_) {
+            return false;
+        }
+        ofPoint shift(motion->x.predict(lookAheadFrames_) - hand.centroid.x, motion->y.predict(lookAheadFrames_) - hand.centroid.y);
+        quad.resize(hand.quad.size());
+        for (int k = 0; k < hand.quad.size(); k++) {
+            quad[k] = hand.quad[k] + shift;
+        }
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    void TouchPredictor::updatePairs(const vector<pair<unsigned int, unsigned int> >& predicted, const vector<unsigned int>& deadObjectLabels, const vector<unsigned int>& deadHandLabels, vector<TouchPredictedEvent>& events){
+        for (int i = 0; i < pairs.size(); i++) {
+            pairs[i].bPredicted = false;
+        }
+        for (int k = 0; k < predicted.size(); k++) {
+            PairState* state = findPair(predicted[k].first, predicted[k].second);
+            if (!state) {
+                pairs.push_back(PairState());
+                state = &pairs.back();
+                state->objectLabel = predicted[k].first;
+                state->handLabel = predicted[k].second;
+                state->hits = state->misses = 0;
+                state->bRaised = false;
+            }
+            state->bPredicted = true;
+        }
+
+        for (int i = pairs.size() - 1; i >= 0; i--) {
+            PairState& state = pairs[i];
+            bool dead = find(deadObjectLabels.begin(), deadObjectLabels.end(), state.objectLabel) != deadObjectLabels.end()
+                || find(deadHandLabels.begin(), deadHandLabels.end(), state.handLabel) != deadHandLabels.end();
+            if (state.bPredicted && !dead) {
+                state.hits++;
+                state.misses = 0;
+            } else {
+                state.misses++;
+                state.hits = 0;
+            }
+
+            if (!state.bRaised && state.hits >= onFrames_) {
+                state.bRaised = true;
+                addEvent(state, true, events);
+            } else if (dead || state.misses >= (state.bRaised ? offFrames_ : 1)) {
+                if (state.bRaised) {
+                    addEvent(state, false, events);
+                }
+                pairs.erase(pairs.begin() + i);
+            }
+        }
+    }
+
+    //A touch happened: nothing left to predict for the pair
+    void TouchPredictor::confirm(unsigned int objectLabel, unsigned int handLabel){
+        for (int i = 0; i < pairs.size(); i++) {
+            if (pairs[i].objectLabel == objectLabel && pairs[i].handLabel == handLabel) {
+                pairs.erase(pairs.begin() + i);
+                return;
+            }
+        }
+    }
+
+    void TouchPredictor::clear(){
+        motions.clear();
+        pairs.clear();
+    }
+
+    TouchPredictor::PairState* TouchPredictor::findPair(unsigned int objectLabel, unsigned int handLabel){
+        for (int i = 0; i < pairs.size(); i++) {
+            if (pairs[i].objectLabel == objectLabel && pairs[i].handLabel == handLabel) {
+                return &pairs[i];
+            }
+        }
+        return NULL;
+    }
+
+    void TouchPredictor::addEvent(const PairState& state, bool predicted, vector<TouchPredictedEvent>& events){
+        events.push_back(TouchPredictedEvent());
+        events.back().objectLabel = state.objectLabel;
+        events.back().handLabel = state.handLabel;
+        events.back().predicted = predicted;
+    }
+
+} //namespace ofxKinectObjects
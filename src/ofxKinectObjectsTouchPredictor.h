@@ -0,0 +1,87 @@
+//
+//  ofxKinectObjectsTouchPredictor.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include "ofxKinectObjectsPipeline.h"
+#include "ofxKinectObjectsSlotMap.h"
+#include "ofxKinectObjectsEvents.h"
+
+namespace ofxKinectObjects {
+
+    //Constant velocity Kalman filter of one coordinate, in units and frames
+    struct MotionFilter{
+        MotionFilter();
+        void reset(float position);
+        //Advance frames frames and correct with a measurement
+        void update(float measurement, float frames, float processNoise, float measurementNoise);
+        float predict(float frames) const;
+        float position, velocity;
+        //Covariance of position and velocity
+        float p00, p01, p11;
+    };
+
+    //Motion state of one hand, in the pixels of the sensor that sees it
+    struct HandMotion{
+        HandMotion();
+        int sensor;
+        unsigned long long frameNumber;
+        int observations;
+        MotionFilter x, y;
+        //Distance to the background (mm), if the hand had depth
+        MotionFilter height;
+        bool bHeight;
+    };
+
+    // Predicts touches before the hand gets to the object. Every hand has
+    // a motion filter over its centroid and height, keyed by its tracker
+    // label, and its quad is moved where the filter says it will be after
+    // the look-ahead. ObjectTracker tests those quads against the objects;
+    // a pair predicted onFrames frames in a row raises a TouchPredictedEvent,
+    // and one not predicted offFrames frames in a row withdraws it. A pair
+    // that touches for real is just dropped: the TouchEvent follows.
+    class TouchPredictor{
+    public:
+        TouchPredictor();
+        //Milliseconds ahead (0, off), at the kinect's 30 frames per second
+        void setLookAhead(float millis);
+        float getLookAhead() const;
+        bool isEnabled() const;
+        void setHysteresis(int onFrames, int offFrames);
+        //Kinect pixels for x and y, mm for the height
+        void setNoise(float processNoise, float measurementNoise);
+
+        //Filters the hands of a tracking result, first instance of each label only
+        void updateHands(const vector<TrackedBlob>& hands, const vector<unsigned int>& deadHandLabels, unsigned long long frameNumber);
+        //Quad of a hand after the look-ahead. False for hands not filtered yet,
+        //without a height, and going up: those are leaving, not touching.
+        bool predictQuad(const TrackedBlob& hand, vector<ofPoint>& quad);
+
+        //(object, hand) pairs whose quads meet after the look-ahead and that
+        //don't touch yet. Appends the predictions raised and withdrawn.
+        void updatePairs(const vector<pair<unsigned int, unsigned int> >& predicted, const vector<unsigned int>& deadObjectLabels, const vector<unsigned int>& deadHandLabels, vector<TouchPredictedEvent>& events);
+        void confirm(unsigned int objectLabel, unsigned int handLabel);
+        void clear();
+
+    private:
+        struct PairState{
+            unsigned int objectLabel, handLabel;
+            int hits, misses;
+            bool bPredicted, bRaised;
+        };
+        PairState* findPair(unsigned int objectLabel, unsigned int handLabel);
+        void addEvent(const PairState& state, bool predicted, vector<TouchPredictedEvent>& events);
+
+        float lookAheadFrames_;
+        int onFrames_, offFrames_;
+        float processNoise_, measurementNoise_;
+        SlotMap<HandMotion> motions;
+        vector<unsigned int> seen;
+        vector<PairState> pairs;
+    };
+
+} //namespace ofxKinectObjects
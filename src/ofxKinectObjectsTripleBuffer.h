@@ -0,0 +1,64 @@
+//
+//  ofxKinectObjectsTripleBuffer.h
+//  kinectObjects
+//
+//  Created by Álvaro Sarasúa Berodia.
+//
+//
+
+#pragma once
+#include <atomic>
+
+namespace ofxKinectObjects {
+
+    // Lock-free hand-off of the latest value from one producer thread to one
+    // consumer thread. The producer fills getBack() and publish()es it, the
+    // consumer calls consume() and reads getFront(). Neither side ever waits;
+    // values published faster than they are consumed are dropped.
+    template <class T>
+    class TripleBuffer{
+    public:
+        TripleBuffer() : back_(0), front_(1), middle_(2) {}
+
+        //Producer side
+        T& getBack(){
+            return buffers_[back_];
+        }
+
+        //Returns true if the previously published value was never consumed
+        bool publish(){
+            int previous = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel);
+            back_ = previous & INDEX;
+            return (previous & FRESH) != 0;
+        }
+
+        //A published value is waiting to be consumed
+        bool isPending() const{
+            return (middle_.load(std::memory_order_acquire) & FRESH) != 0;
+        }
+
+        //Consumer side: returns true if getFront() changed
+        bool consume(){
+            if (!isPending()) {
+                return false;
+            }
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        T& getFront(){
+            return buffers_[front_];
+        }
+
+    private:
+        enum { INDEX = 3, FRESH = 4 };
+
+        TripleBuffer(const TripleBuffer&);
+        TripleBuffer& operator=(const TripleBuffer&);
+
+        T buffers_[3];
+        int back_, front_;
+        std::atomic<int> middle_;
+    };
+
+} //namespace ofxKinectObjects